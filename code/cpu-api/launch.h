@@ -0,0 +1,100 @@
+#ifndef __launch_h__
+#define __launch_h__
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <signal.h>
+#include <spawn.h>
+#include <assert.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+
+// Start a program with its stdout redirected to a file, like p4.c does, but
+// without necessarily paying for fork(). fork() copies the parent's page
+// tables (proportional to its RSS) only for execvp() to throw them away;
+// the other methods share the parent's memory until the child execs.
+//
+//   LAUNCH_FORK  - fork, redirect, execvp (p4.c)
+//   LAUNCH_VFORK - vfork, redirect, execvp; the parent is suspended until exec
+//   LAUNCH_SPAWN - posix_spawnp with a file action doing the redirect
+//   LAUNCH_CLONE - clone(CLONE_VM|CLONE_VFORK) on a small private stack
+//
+// launch() returns the child's pid once the parent may run again, or -1.
+
+typedef enum { LAUNCH_FORK, LAUNCH_VFORK, LAUNCH_SPAWN, LAUNCH_CLONE } launch_method_t;
+
+extern char **environ;
+
+// in the child: point stdout at path (NULL leaves it alone) and exec
+void
+launch_exec(char *const argv[], const char *path)
+{
+    if (path != NULL) {
+        int fd = open(path, O_CREAT|O_WRONLY|O_TRUNC, S_IRWXU);
+        if (fd < 0)
+            _exit(127);
+        if (fd != STDOUT_FILENO) {
+            dup2(fd, STDOUT_FILENO);
+            close(fd);
+        }
+    }
+    execvp(argv[0], argv);
+    _exit(127); // only _exit is safe here: the child may share the parent's memory
+}
+
+typedef struct {
+    char *const *argv;
+    const char *path;
+} launch_args_t;
+
+int
+launch_clone_child(void *arg)
+{
+    launch_args_t *a = (launch_args_t *)arg;
+    launch_exec(a->argv, a->path);
+    return 127;
+}
+
+#define LAUNCH_STACK (64 * 1024)
+
+pid_t
+launch(launch_method_t how, char *const argv[], const char *path)
+{
+    pid_t rc = -1;
+    if (how == LAUNCH_FORK) {
+        rc = fork();
+        if (rc == 0)
+            launch_exec(argv, path);
+    } else if (how == LAUNCH_VFORK) {
+        rc = vfork();
+        if (rc == 0)
+            launch_exec(argv, path);
+    } else if (how == LAUNCH_SPAWN) {
+        posix_spawn_file_actions_t fa;
+        posix_spawn_file_actions_init(&fa);
+        if (path != NULL)
+            posix_spawn_file_actions_addopen(&fa, STDOUT_FILENO, path,
+                                             O_CREAT|O_WRONLY|O_TRUNC, S_IRWXU);
+        if (posix_spawnp(&rc, argv[0], &fa, NULL, argv, environ) != 0)
+            rc = -1;
+        posix_spawn_file_actions_destroy(&fa);
+    } else {
+        // the child runs on this stack in our address space until it execs;
+        // CLONE_VFORK keeps us suspended until then, so the stack can go right after
+        char *stack = mmap(NULL, LAUNCH_STACK, PROT_READ|PROT_WRITE,
+                           MAP_PRIVATE|MAP_ANONYMOUS|MAP_STACK, -1, 0);
+        if (stack == MAP_FAILED)
+            return -1;
+        launch_args_t a = { argv, path };
+        rc = clone(launch_clone_child, stack + LAUNCH_STACK,
+                   CLONE_VM|CLONE_VFORK|SIGCHLD, &a);
+        munmap(stack, LAUNCH_STACK);
+    }
+    return rc;
+}
+
+#endif // __launch_h__
@@ -0,0 +1,204 @@
+#ifndef __pipeline_h__
+#define __pipeline_h__
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <assert.h>
+#include <sys/wait.h>
+#include <sys/sendfile.h>
+
+// A multi-stage pipeline of child processes, connected by pipes the way a
+// shell connects "a | b | c". Every stage is a function run in its own child
+// with stdin and stdout already pointing at the right pipe (p4.c's redirect,
+// done with dup2 instead of close+open).
+//
+// The stages below move data with sendfile/splice/tee, so the bytes stay in
+// kernel pipe buffers and page cache instead of being copied into user space
+// and back. pl_rw_copy is the read/write version, for comparison.
+
+#define PL_MAX_STAGES 16
+#define PL_CHUNK      (1 << 20)  // bytes per splice/read call
+#define PL_PIPE_SIZE  (1 << 20)  // pipe buffer size requested with F_SETPIPE_SZ
+
+typedef void (*pl_stage_fn)(void *arg);
+
+typedef struct {
+    int nstages;
+    pl_stage_fn fn[PL_MAX_STAGES];
+    void *arg[PL_MAX_STAGES];
+} pipeline_t;
+
+void
+pl_init(pipeline_t *p)
+{
+    p->nstages = 0;
+}
+
+void
+pl_add(pipeline_t *p, pl_stage_fn fn, void *arg)
+{
+    assert(p->nstages < PL_MAX_STAGES);
+    p->fn[p->nstages] = fn;
+    p->arg[p->nstages] = arg;
+    p->nstages++;
+}
+
+// Fork one child per stage; stage 0 reads in_fd, the last stage writes out_fd.
+// Waits for all stages and returns 0 if every one of them exited with status 0.
+int
+pl_run(pipeline_t *p, int in_fd, int out_fd)
+{
+    pid_t pids[PL_MAX_STAGES];
+    int prev = in_fd;
+    int i;
+    for (i = 0; i < p->nstages; i++) {
+        int fd[2] = { -1, out_fd };
+        if (i < p->nstages - 1) {
+            assert(pipe(fd) == 0);
+            fcntl(fd[1], F_SETPIPE_SZ, PL_PIPE_SIZE); // best effort; limited by pipe-max-size
+        }
+        pids[i] = fork();
+        if (pids[i] < 0) {
+            fprintf(stderr, "fork failed\n");
+            exit(1);
+        } else if (pids[i] == 0) {
+            if (fd[0] >= 0)
+                close(fd[0]);
+            dup2(prev, STDIN_FILENO);
+            dup2(fd[1], STDOUT_FILENO);
+            p->fn[i](p->arg[i]);
+            _exit(0);
+        }
+        if (prev != in_fd)
+            close(prev);
+        if (fd[1] != out_fd)
+            close(fd[1]);
+        prev = fd[0];
+    }
+    int ok = 0;
+    for (i = 0; i < p->nstages; i++) {
+        int status;
+        waitpid(pids[i], &status, 0);
+        if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+            ok = -1;
+    }
+    return ok;
+}
+
+void
+pl_die(const char *what)
+{
+    perror(what);
+    _exit(1);
+}
+
+// stdin -> stdout with splice; one end must be a pipe
+void
+pl_splice(void *arg)
+{
+    for (;;) {
+        ssize_t n = splice(STDIN_FILENO, NULL, STDOUT_FILENO, NULL, PL_CHUNK,
+                           SPLICE_F_MOVE | SPLICE_F_MORE);
+        if (n == 0)
+            return;
+        if (n < 0)
+            pl_die("splice");
+    }
+}
+
+// source stage: a regular file on stdin -> stdout with sendfile
+// (falls back to splice where sendfile cannot write to a pipe)
+void
+pl_sendfile(void *arg)
+{
+    for (;;) {
+        ssize_t n = sendfile(STDOUT_FILENO, STDIN_FILENO, NULL, PL_CHUNK);
+        if (n == 0)
+            return;
+        if (n < 0) {
+            if (errno == EINVAL) {
+                pl_splice(arg);
+                return;
+            }
+            pl_die("sendfile");
+        }
+    }
+}
+
+// fan-out: duplicate the stdin pipe onto the stdout pipe with tee, then move
+// the same bytes from stdin to the extra fd (*(int *)arg) with splice
+void
+pl_tee(void *arg)
+{
+    int extra = *(int *)arg;
+    for (;;) {
+        ssize_t n = tee(STDIN_FILENO, STDOUT_FILENO, PL_CHUNK, 0);
+        if (n == 0)
+            return;
+        if (n < 0)
+            pl_die("tee");
+        while (n > 0) {
+            ssize_t m = splice(STDIN_FILENO, NULL, extra, NULL, n, SPLICE_F_MOVE | SPLICE_F_MORE);
+            if (m <= 0)
+                pl_die("splice");
+            n -= m;
+        }
+    }
+}
+
+// stdin -> stdout through a user-space buffer
+void
+pl_rw_copy(void *arg)
+{
+    char *buf = malloc(PL_CHUNK);
+    assert(buf != NULL);
+    for (;;) {
+        ssize_t n = read(STDIN_FILENO, buf, PL_CHUNK);
+        if (n == 0)
+            break;
+        if (n < 0)
+            pl_die("read");
+        ssize_t off = 0;
+        while (off < n) {
+            ssize_t m = write(STDOUT_FILENO, buf + off, n - off);
+            if (m < 0)
+                pl_die("write");
+            off += m;
+        }
+    }
+    free(buf);
+}
+
+// fan-out with read/write: every chunk is written to stdout and to the extra fd
+void
+pl_rw_tee(void *arg)
+{
+    int extra = *(int *)arg;
+    char *buf = malloc(PL_CHUNK);
+    assert(buf != NULL);
+    for (;;) {
+        ssize_t n = read(STDIN_FILENO, buf, PL_CHUNK);
+        if (n == 0)
+            break;
+        if (n < 0)
+            pl_die("read");
+        int fds[2] = { STDOUT_FILENO, extra };
+        int k;
+        for (k = 0; k < 2; k++) {
+            ssize_t off = 0;
+            while (off < n) {
+                ssize_t m = write(fds[k], buf + off, n - off);
+                if (m < 0)
+                    pl_die("write");
+                off += m;
+            }
+        }
+    }
+    free(buf);
+}
+
+#endif // __pipeline_h__
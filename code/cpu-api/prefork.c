@@ -0,0 +1,304 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <string.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <semaphore.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include "cycles.h"
+
+// A prefork worker pool: workers are forked once and take tasks from a ring
+// that lives in an mmap(MAP_SHARED) region, synchronized with process-shared
+// semaphores. Each task is a word count (what p3.c asks wc to do); results are
+// written back into the task's slot in the same region.
+//
+// Compared against:
+//   fork+exec   - what p3.c does: fork, execvp("wc"), read its stdout via a pipe
+//   fork        - fork per task, the child counts and returns the result via a pipe
+//   pool        - the prefork pool, one task in flight (latency)
+//   pool-batch  - the prefork pool, the ring kept full (throughput)
+//
+// usage: ./prefork [file] [tasks] [workers]
+
+#define RING 64
+
+typedef struct {
+    char path[PATH_MAX];
+    long lines, words, bytes;
+    int status;           // 0 ok, -1 could not read the file
+    sem_t done;           // posted by the worker when the result is in place
+} task_t;
+
+typedef struct {
+    sem_t mutex;          // protects head and tail
+    sem_t items;          // tasks waiting in the ring
+    sem_t spaces;         // free ring entries
+    int head, tail;
+    int ring[RING];       // slot numbers; -1 tells a worker to exit
+    task_t slots[RING];
+} pool_t;
+
+pool_t *pool;
+int nworkers = 4;
+pid_t *workers;
+
+// the "untrusted parser": counts like wc (lines, words, bytes)
+int
+count_file(const char *path, long *lines, long *words, long *bytes)
+{
+    char buf[65536];
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+        return -1;
+    long l = 0, w = 0, b = 0;
+    int inword = 0;
+    ssize_t n;
+    while ((n = read(fd, buf, sizeof(buf))) > 0) {
+        ssize_t i;
+        b += n;
+        for (i = 0; i < n; i++) {
+            char c = buf[i];
+            if (c == '\n')
+                l++;
+            if (c == ' ' || c == '\n' || c == '\t' || c == '\r' || c == '\v' || c == '\f') {
+                inword = 0;
+            } else if (!inword) {
+                inword = 1;
+                w++;
+            }
+        }
+    }
+    close(fd);
+    *lines = l;
+    *words = w;
+    *bytes = b;
+    return n < 0 ? -1 : 0;
+}
+
+void
+worker_loop(void)
+{
+    for (;;) {
+        sem_wait(&pool->items);
+        sem_wait(&pool->mutex);
+        int s = pool->ring[pool->head];
+        pool->head = (pool->head + 1) % RING;
+        sem_post(&pool->mutex);
+        sem_post(&pool->spaces);
+        if (s < 0)
+            _exit(0);
+        task_t *t = &pool->slots[s];
+        t->status = count_file(t->path, &t->lines, &t->words, &t->bytes);
+        sem_post(&t->done);
+    }
+}
+
+void
+pool_start(void)
+{
+    pool = mmap(NULL, sizeof(pool_t), PROT_READ | PROT_WRITE,
+                MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    assert(pool != MAP_FAILED);
+    // pshared = 1: the semaphores live in shared memory and are used by several processes
+    assert(sem_init(&pool->mutex, 1, 1) == 0);
+    assert(sem_init(&pool->items, 1, 0) == 0);
+    assert(sem_init(&pool->spaces, 1, RING) == 0);
+    pool->head = pool->tail = 0;
+    int i;
+    for (i = 0; i < RING; i++)
+        assert(sem_init(&pool->slots[i].done, 1, 0) == 0);
+    workers = malloc(sizeof(pid_t) * nworkers);
+    assert(workers != NULL);
+    for (i = 0; i < nworkers; i++) {
+        workers[i] = fork();
+        if (workers[i] < 0) {
+            fprintf(stderr, "fork failed\n");
+            exit(1);
+        } else if (workers[i] == 0) {
+            worker_loop();
+        }
+    }
+}
+
+void
+pool_push(int s)
+{
+    sem_wait(&pool->spaces);
+    sem_wait(&pool->mutex);
+    pool->ring[pool->tail] = s;
+    pool->tail = (pool->tail + 1) % RING;
+    sem_post(&pool->mutex);
+    sem_post(&pool->items);
+}
+
+void
+pool_submit(int s, const char *path)
+{
+    strncpy(pool->slots[s].path, path, PATH_MAX - 1);
+    pool->slots[s].path[PATH_MAX - 1] = '\0';
+    pool_push(s);
+}
+
+void
+pool_stop(void)
+{
+    int i;
+    for (i = 0; i < nworkers; i++)
+        pool_push(-1);
+    for (i = 0; i < nworkers; i++)
+        waitpid(workers[i], NULL, 0);
+    free(workers);
+    munmap(pool, sizeof(pool_t));
+}
+
+// fork+exec wc the way p3.c does, with its stdout captured through a pipe
+void
+fork_exec_wc(const char *path, long *lines, long *words, long *bytes)
+{
+    int fd[2];
+    assert(pipe(fd) == 0);
+    int rc = fork();
+    if (rc < 0) {
+        fprintf(stderr, "fork failed\n");
+        exit(1);
+    } else if (rc == 0) {
+        close(fd[0]);
+        dup2(fd[1], STDOUT_FILENO);
+        char *myargs[3];
+        myargs[0] = "wc";
+        myargs[1] = (char *)path;
+        myargs[2] = NULL;
+        execvp(myargs[0], myargs);
+        _exit(1);
+    }
+    close(fd[1]);
+    char out[PATH_MAX + 64];
+    ssize_t n, len = 0;
+    while ((n = read(fd[0], out + len, sizeof(out) - 1 - len)) > 0)
+        len += n;
+    out[len] = '\0';
+    close(fd[0]);
+    waitpid(rc, NULL, 0);
+    assert(sscanf(out, "%ld %ld %ld", lines, words, bytes) == 3);
+}
+
+// fork per task without exec: the child runs the same parser as the pool
+void
+fork_count(const char *path, long *lines, long *words, long *bytes)
+{
+    int fd[2];
+    long r[3];
+    assert(pipe(fd) == 0);
+    int rc = fork();
+    if (rc < 0) {
+        fprintf(stderr, "fork failed\n");
+        exit(1);
+    } else if (rc == 0) {
+        close(fd[0]);
+        count_file(path, &r[0], &r[1], &r[2]);
+        assert(write(fd[1], r, sizeof(r)) == sizeof(r));
+        _exit(0);
+    }
+    close(fd[1]);
+    assert(read(fd[0], r, sizeof(r)) == sizeof(r));
+    close(fd[0]);
+    waitpid(rc, NULL, 0);
+    *lines = r[0];
+    *words = r[1];
+    *bytes = r[2];
+}
+
+void
+report(const char *name, uint64_t *lat, long n, uint64_t total)
+{
+    printf("%-12s %12.0f", name, n / (cycles_to_ns(total) / 1e9));
+    qsort(lat, n, sizeof(uint64_t), cycles_cmp);
+    printf(" %10.1f %10.1f %10.1f\n",
+           cycles_to_ns(cycles_percentile(lat, n, 50)) / 1000,
+           cycles_to_ns(cycles_percentile(lat, n, 99)) / 1000,
+           cycles_to_ns(lat[n - 1]) / 1000);
+}
+
+int
+main(int argc, char *argv[])
+{
+    char *file = argc > 1 ? argv[1] : "p3.c";
+    long ntasks = argc > 2 ? atol(argv[2]) : 2000;
+    if (argc > 3)
+        nworkers = atoi(argv[3]);
+    if (argc > 4 || ntasks <= 0 || nworkers <= 0) {
+        fprintf(stderr, "usage: prefork [file] [tasks] [workers]\n");
+        exit(1);
+    }
+    uint64_t *lat = malloc(sizeof(uint64_t) * ntasks);
+    assert(lat != NULL);
+    cycles_calibrate(50);
+
+    long want[3], got[3];
+    if (count_file(file, &want[0], &want[1], &want[2]) < 0) {
+        fprintf(stderr, "cannot read %s\n", file);
+        exit(1);
+    }
+    printf("file: %s (%ld lines, %ld words, %ld bytes)  tasks: %ld  workers: %d\n\n",
+           file, want[0], want[1], want[2], ntasks, nworkers);
+    printf("%-12s %12s %10s %10s %10s\n", "method", "tasks/sec", "p50-us", "p99-us", "max-us");
+
+    long i;
+    uint64_t start = cycles_now();
+    for (i = 0; i < ntasks; i++) {
+        uint64_t t0 = cycles_now();
+        fork_exec_wc(file, &got[0], &got[1], &got[2]);
+        lat[i] = cycles_now() - t0;
+        assert(memcmp(got, want, sizeof(want)) == 0);
+    }
+    report("fork+exec", lat, ntasks, cycles_now() - start);
+
+    start = cycles_now();
+    for (i = 0; i < ntasks; i++) {
+        uint64_t t0 = cycles_now();
+        fork_count(file, &got[0], &got[1], &got[2]);
+        lat[i] = cycles_now() - t0;
+        assert(memcmp(got, want, sizeof(want)) == 0);
+    }
+    report("fork", lat, ntasks, cycles_now() - start);
+
+    pool_start();
+    start = cycles_now();
+    for (i = 0; i < ntasks; i++) {
+        uint64_t t0 = cycles_now();
+        pool_submit(0, file);
+        sem_wait(&pool->slots[0].done);
+        lat[i] = cycles_now() - t0;
+        task_t *t = &pool->slots[0];
+        assert(t->status == 0 && t->lines == want[0] && t->words == want[1] && t->bytes == want[2]);
+    }
+    report("pool", lat, ntasks, cycles_now() - start);
+
+    // keep up to RING tasks in flight; slot i % RING is reused only after its result is collected
+    uint64_t *submitted = malloc(sizeof(uint64_t) * RING);
+    assert(submitted != NULL);
+    long collected = 0;
+    start = cycles_now();
+    for (i = 0; i < ntasks + RING; i++) {
+        int s = i % RING;
+        if (i >= RING && i - RING < ntasks) {
+            sem_wait(&pool->slots[s].done);
+            lat[collected++] = cycles_now() - submitted[s];
+            task_t *t = &pool->slots[s];
+            assert(t->status == 0 && t->lines == want[0] && t->words == want[1] && t->bytes == want[2]);
+        }
+        if (i < ntasks) {
+            submitted[s] = cycles_now();
+            pool_submit(s, file);
+        }
+    }
+    assert(collected == ntasks);
+    report("pool-batch", lat, ntasks, cycles_now() - start);
+    pool_stop();
+
+    free(submitted);
+    free(lat);
+    return 0;
+}
@@ -0,0 +1,82 @@
+#include "launch.h"
+#include <string.h>
+#include "cycles.h"
+
+// How long the parent stalls in launch() as its resident set grows.
+// The parent touches every page of a heap that doubles from 10 MB up to
+// max-MB, and at each size launches "wc p4.c > ./p4.output" (as p4.c does)
+// with every method in launch.h. Output is one row per size, suitable for
+// plotting: the p50 and p99 stall in microseconds for each method.
+//
+// usage: ./spawnbench [max-MB] [trials]
+
+const char *names[] = { "fork", "vfork", "spawn", "clone" };
+
+int
+main(int argc, char *argv[])
+{
+    long max_mb = argc > 1 ? atol(argv[1]) : 10240;
+    int trials = argc > 2 ? atoi(argv[2]) : 20;
+    if (argc > 3 || max_mb < 10 || trials <= 0) {
+        fprintf(stderr, "usage: spawnbench [max-MB] [trials]\n");
+        exit(1);
+    }
+    // leave a quarter of physical memory free; touching more than that ends in the OOM killer
+    long phys_mb = sysconf(_SC_PHYS_PAGES) / 1024 * sysconf(_SC_PAGESIZE) / 1024;
+    if (max_mb > phys_mb * 3 / 4) {
+        max_mb = phys_mb * 3 / 4;
+        fprintf(stderr, "spawnbench: only %ld MB of memory, stopping at %ld MB\n", phys_mb, max_mb);
+    }
+
+    char *myargs[3];
+    myargs[0] = strdup("wc");   // program: "wc" (word count)
+    myargs[1] = strdup("p4.c"); // argument: file to count
+    myargs[2] = NULL;
+    uint64_t *lat = malloc(sizeof(uint64_t) * trials);
+    assert(lat != NULL);
+    cycles_calibrate(50);
+
+    printf("%8s", "rss-MB");
+    int m;
+    for (m = LAUNCH_FORK; m <= LAUNCH_CLONE; m++)
+        printf(" %9s-p50 %9s-p99", names[m], names[m]);
+    printf("\n");
+
+    char *heap = NULL;
+    long mb;
+    for (mb = 10; ; mb *= 2) {
+        if (mb > max_mb)
+            mb = max_mb;
+        // grow the heap and touch every page so it is really resident
+        heap = realloc(heap, mb << 20);
+        assert(heap != NULL);
+        long off;
+        for (off = 0; off < (mb << 20); off += 4096)
+            heap[off] = 1;
+
+        printf("%8ld", mb);
+        for (m = LAUNCH_FORK; m <= LAUNCH_CLONE; m++) {
+            int i;
+            for (i = 0; i < trials; i++) {
+                uint64_t t0 = cycles_now();
+                pid_t rc = launch(m, myargs, "./p4.output");
+                lat[i] = cycles_now() - t0;
+                assert(rc > 0);
+                int status;
+                assert(waitpid(rc, &status, 0) == rc);
+                assert(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+            }
+            qsort(lat, trials, sizeof(uint64_t), cycles_cmp);
+            printf(" %13.1f %13.1f",
+                   cycles_to_ns(cycles_percentile(lat, trials, 50)) / 1000,
+                   cycles_to_ns(cycles_percentile(lat, trials, 99)) / 1000);
+        }
+        printf("\n");
+        fflush(stdout);
+        if (mb == max_mb)
+            break;
+    }
+    free(heap);
+    free(lat);
+    return 0;
+}
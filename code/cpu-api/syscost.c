@@ -0,0 +1,202 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <string.h>
+#include <spawn.h>
+#include <sys/wait.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#include "common_threads.h"
+#include "timing.h"
+
+// Measures the costs that p1.c-p4.c only demonstrate:
+//   null syscall, context switch via pipe ping-pong between two pinned
+//   processes, futex handoff between two pinned threads, and
+//   fork/vfork/posix_spawn followed by wait.
+// All timing uses the calibrated cycle counter from cycles.h; every test
+// records each operation's cycles into a log-bucketed histogram (timing.h)
+// and reports mean and percentiles in nanoseconds.
+//
+// usage: ./syscost [iterations] [cpu-a] [cpu-b]
+//   cpu-a == cpu-b (the default, 0 0) measures a real context switch;
+//   different CPUs measure a cross-CPU wakeup instead.
+
+extern char **environ;
+
+long iters = 100000;
+int cpu_a = 0, cpu_b = 0;
+hdr_hist_t *hist;
+
+void
+null_syscall(void)
+{
+    long i;
+    for (i = 0; i < iters; i++) {
+        uint64_t t0 = cycles_now();
+        syscall(SYS_getpid); // glibc no longer caches getpid(), but be explicit
+        uint64_t t1 = cycles_now();
+        uint64_t d = t1 - t0;
+        hdr_record(hist, d > cycles_overhead ? d - cycles_overhead : 0);
+    }
+    hdr_report("null syscall", hist, 1 / cycles_per_ns);
+    hdr_reset(hist);
+}
+
+void
+pipe_pingpong(void)
+{
+    int ping[2], pong[2];
+    char c = 'x';
+    assert(pipe(ping) == 0 && pipe(pong) == 0);
+    int rc = fork();
+    if (rc < 0) {
+        fprintf(stderr, "fork failed\n");
+        exit(1);
+    } else if (rc == 0) {
+        // child: echo every byte back until the parent closes its end
+        Pin_to_cpu(cpu_b);
+        close(ping[1]);
+        close(pong[0]);
+        while (read(ping[0], &c, 1) == 1)
+            assert(write(pong[1], &c, 1) == 1);
+        _exit(0);
+    }
+    Pin_to_cpu(cpu_a);
+    close(ping[0]);
+    close(pong[1]);
+    long i;
+    for (i = -1000; i < iters; i++) { // negative i: warm-up round trips
+        uint64_t t0 = cycles_now();
+        assert(write(ping[1], &c, 1) == 1);
+        assert(read(pong[0], &c, 1) == 1);
+        uint64_t t1 = cycles_now();
+        if (i >= 0)
+            hdr_record(hist, t1 - t0);
+    }
+    close(ping[1]);
+    close(pong[0]);
+    waitpid(rc, NULL, 0);
+    Pin_to_cpu(-1);
+    // one round trip = two switches (parent -> child -> parent)
+    hdr_report("pipe switch (rtt/2)", hist, 1 / (cycles_per_ns * 2));
+    hdr_reset(hist);
+}
+
+int turn; // 0: ping's turn, 1: pong's turn
+
+void
+futex_wait(int *addr, int val)
+{
+    syscall(SYS_futex, addr, FUTEX_WAIT_PRIVATE, val, NULL, NULL, 0);
+}
+
+void
+futex_wake(int *addr)
+{
+    syscall(SYS_futex, addr, FUTEX_WAKE_PRIVATE, 1, NULL, NULL, 0);
+}
+
+void *
+pong_thread(void *arg)
+{
+    long n = *(long *)arg, i;
+    for (i = 0; i < n; i++) {
+        while (__atomic_load_n(&turn, __ATOMIC_ACQUIRE) == 0)
+            futex_wait(&turn, 0);
+        __atomic_store_n(&turn, 0, __ATOMIC_RELEASE);
+        futex_wake(&turn);
+    }
+    return NULL;
+}
+
+void
+futex_handoff(void)
+{
+    long total = iters + 1000;
+    pthread_t p;
+    turn = 0;
+    Pin_to_cpu(cpu_a);
+    Pthread_create_on_cpu(&p, cpu_b, pong_thread, &total);
+    long i;
+    for (i = -1000; i < iters; i++) {
+        uint64_t t0 = cycles_now();
+        __atomic_store_n(&turn, 1, __ATOMIC_RELEASE);
+        futex_wake(&turn);
+        while (__atomic_load_n(&turn, __ATOMIC_ACQUIRE) == 1)
+            futex_wait(&turn, 1);
+        uint64_t t1 = cycles_now();
+        if (i >= 0)
+            hdr_record(hist, t1 - t0);
+    }
+    Pthread_join(p, NULL);
+    Pin_to_cpu(-1);
+    hdr_report("futex handoff (rtt/2)", hist, 1 / (cycles_per_ns * 2));
+    hdr_reset(hist);
+}
+
+typedef enum { USE_FORK, USE_VFORK, USE_SPAWN } spawn_t;
+
+void
+spawn_wait(spawn_t how, long n, const char *name)
+{
+    char *args[] = { "true", NULL };
+    long i;
+    for (i = 0; i < n; i++) {
+        uint64_t t0 = cycles_now();
+        int rc;
+        if (how == USE_FORK) {
+            rc = fork();
+            if (rc == 0)
+                _exit(0);
+        } else if (how == USE_VFORK) {
+            rc = vfork();
+            if (rc == 0)
+                _exit(0);
+        } else {
+            // posix_spawn also pays for exec, so /bin/true is the cheapest program to run
+            assert(posix_spawn(&rc, "/bin/true", NULL, NULL, args, environ) == 0);
+        }
+        assert(rc > 0);
+        waitpid(rc, NULL, 0);
+        hdr_record(hist, cycles_now() - t0);
+    }
+    hdr_report(name, hist, 1 / cycles_per_ns);
+    hdr_reset(hist);
+}
+
+int
+main(int argc, char *argv[])
+{
+    if (argc > 1)
+        iters = atol(argv[1]);
+    if (argc > 2)
+        cpu_a = cpu_b = atoi(argv[2]);
+    if (argc > 3)
+        cpu_b = atoi(argv[3]);
+    if (argc > 4 || iters <= 0) {
+        fprintf(stderr, "usage: syscost [iterations] [cpu-a] [cpu-b]\n");
+        exit(1);
+    }
+    hist = hdr_new();
+
+    cycles_calibrate(100);
+    printf("counter: %.3f cycles/ns, read overhead %.1f ns\n",
+           cycles_per_ns, cycles_to_ns(cycles_overhead));
+    printf("iterations: %ld  cpus: %d %d  (all times in ns)\n\n", iters, cpu_a, cpu_b);
+    hdr_report_header();
+
+    null_syscall();
+    pipe_pingpong();
+    futex_handoff();
+    // process creation is ~1000x slower than the rest; fewer samples suffice
+    long n = iters / 100 > 100 ? iters / 100 : 100;
+    if (n > iters)
+        n = iters;
+    spawn_wait(USE_FORK, n, "fork + wait");
+    spawn_wait(USE_VFORK, n, "vfork + wait");
+    spawn_wait(USE_SPAWN, n, "posix_spawn + wait");
+
+    free(hist);
+    return 0;
+}
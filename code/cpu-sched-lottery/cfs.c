@@ -0,0 +1,319 @@
+// 完全公平调度器（CFS）模拟：按 vruntime 排序的红黑树
+//   - vruntime += 实际运行时间 * 1024 / weight，weight 来自 nice 值（与 Linux 的权重表相同）
+//   - 调度周期 period = max(sched_latency, nr_running * min_granularity)
+//     任务的时间片 = period * weight / 总权重，且不小于 min_granularity
+//   - 每次选 vruntime 最小的任务（缓存的最左节点）
+//   - 睡眠任务唤醒时放置在 max(自身 vruntime, min_vruntime - sched_latency / 2)，
+//     既给睡眠者一点补偿，又不让它靠很小的 vruntime 长时间独占 CPU
+//   - 任务结构体来自对象池，调度过程中不调用 malloc/free
+//
+// 三部分输出：
+//   1. 入队（插入）与选下一个（删除最左节点）的单次代价
+//   2. 稳态调度循环（含睡眠/唤醒）的每次决策代价
+//   3. 与彩票调度在同一负载下的公平性对比：CPU 时间占比与权重占比之间的总变差距离
+// To compile: make cfs
+// To run:     ./cfs 1 100000 10000000 10
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+
+#include "common.h"
+#include "rbtree.h"
+#include "fenwick.h"
+#include "rng.h"
+
+#define SCHED_LATENCY   6000000L // 6 ms（单位 ns）
+#define MIN_GRANULARITY 750000L  // 0.75 ms
+#define NICE_0_WEIGHT   1024
+#define SLEEP_DECISIONS 64       // 睡眠任务在这么多次调度决策之后醒来
+
+// nice -20 .. 19 对应的权重，相邻两级约差 1.25 倍
+const int prio_to_weight[40] = {
+    88761, 71755, 56483, 46273, 36291,
+    29154, 23254, 18705, 14949, 11916,
+    9548, 7620, 6100, 4904, 3906,
+    3121, 2501, 1991, 1586, 1277,
+    1024, 820, 655, 526, 423,
+    335, 272, 215, 172, 137,
+    110, 87, 70, 56, 45,
+    36, 29, 23, 18, 15};
+
+typedef struct task_t
+{
+    rb_node_t node;
+    long vruntime;
+    long sum_exec; // 累计运行时间（ns）
+    int weight;
+    int id;
+    struct task_t *next_free;
+} task_t;
+
+// ---------------- 对象池 ----------------
+
+task_t *pool_free = NULL;
+
+task_t *task_alloc()
+{
+    if (pool_free == NULL)
+    {
+        int n = 4096, i;
+        task_t *batch = malloc(sizeof(task_t) * n);
+        assert(batch != NULL);
+        for (i = 0; i < n; i++)
+        {
+            batch[i].next_free = pool_free;
+            pool_free = &batch[i];
+        }
+    }
+    task_t *t = pool_free;
+    pool_free = t->next_free;
+    return t;
+}
+
+void task_release(task_t *t)
+{
+    t->next_free = pool_free;
+    pool_free = t;
+}
+
+// ---------------- 运行队列 ----------------
+
+typedef struct
+{
+    rb_tree_t tree;
+    long min_vruntime; // 单调不减
+    long total_weight;
+} cfs_rq_t;
+
+int task_less(rb_node_t *a, rb_node_t *b)
+{
+    task_t *x = rb_entry(a, task_t, node);
+    task_t *y = rb_entry(b, task_t, node);
+    if (x->vruntime != y->vruntime)
+        return x->vruntime < y->vruntime;
+    return x->id < y->id;
+}
+
+void rq_init(cfs_rq_t *rq)
+{
+    rb_init(&rq->tree, task_less);
+    rq->min_vruntime = 0;
+    rq->total_weight = 0;
+}
+
+void enqueue(cfs_rq_t *rq, task_t *t)
+{
+    rb_insert(&rq->tree, &t->node);
+    rq->total_weight += t->weight;
+}
+
+task_t *pick_next(cfs_rq_t *rq)
+{
+    rb_node_t *n = rq->tree.leftmost;
+    if (n == NULL)
+        return NULL;
+    task_t *t = rb_entry(n, task_t, node);
+    rb_erase(&rq->tree, n);
+    rq->total_weight -= t->weight;
+    return t;
+}
+
+// 当前任务（已出队）的时间片：按权重分配调度周期
+long time_slice(cfs_rq_t *rq, task_t *curr)
+{
+    long nr = rq->tree.size + 1;
+    long period = nr * MIN_GRANULARITY > SCHED_LATENCY ? nr * MIN_GRANULARITY : SCHED_LATENCY;
+    long slice = period * curr->weight / (rq->total_weight + curr->weight);
+    return slice < MIN_GRANULARITY ? MIN_GRANULARITY : slice;
+}
+
+void account(cfs_rq_t *rq, task_t *t, long delta)
+{
+    t->sum_exec += delta;
+    t->vruntime += delta * NICE_0_WEIGHT / t->weight;
+    // min_vruntime 跟随树中最小值（或刚运行的任务），但永不后退
+    long m = t->vruntime;
+    if (rq->tree.leftmost)
+    {
+        long left = rb_entry(rq->tree.leftmost, task_t, node)->vruntime;
+        if (left < m)
+            m = left;
+    }
+    if (m > rq->min_vruntime)
+        rq->min_vruntime = m;
+}
+
+// 睡眠者唤醒时的放置
+void place_wakeup(cfs_rq_t *rq, task_t *t)
+{
+    long floor = rq->min_vruntime - SCHED_LATENCY / 2;
+    if (t->vruntime < floor)
+        t->vruntime = floor;
+}
+
+// ---------------- 实验 ----------------
+
+double share_error(long *exec, int *weight, int n)
+{
+    long total_exec = 0, total_weight = 0;
+    int i;
+    for (i = 0; i < n; i++)
+    {
+        total_exec += exec[i];
+        total_weight += weight[i];
+    }
+    double err = 0;
+    for (i = 0; i < n; i++)
+    {
+        double got = (double)exec[i] / total_exec;
+        double want = (double)weight[i] / total_weight;
+        err += got > want ? got - want : want - got;
+    }
+    return err / 2;
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc != 5)
+    {
+        fprintf(stderr, "usage: cfs <seed> <tasks> <decisions> <sleep-pct>\n");
+        exit(1);
+    }
+    int seed = atoi(argv[1]);
+    int ntasks = atoi(argv[2]);
+    long decisions = atol(argv[3]);
+    int sleep_pct = atoi(argv[4]);
+    assert(ntasks > 0 && decisions > 0 && sleep_pct >= 0 && sleep_pct < 100);
+
+    rng_t rng;
+    rng_seed(&rng, seed);
+    task_t **tasks = malloc(sizeof(task_t *) * ntasks);
+    int *weight = malloc(sizeof(int) * ntasks);
+    long *exec = malloc(sizeof(long) * ntasks);
+    assert(tasks != NULL && weight != NULL && exec != NULL);
+    int i;
+    for (i = 0; i < ntasks; i++)
+    {
+        tasks[i] = task_alloc();
+        tasks[i]->id = i;
+        tasks[i]->weight = weight[i] = prio_to_weight[rng_bounded(&rng, 40)];
+        tasks[i]->vruntime = 0;
+        tasks[i]->sum_exec = 0;
+    }
+
+    // 1. 入队与选下一个的单次代价：先插入全部任务，再按 vruntime 顺序取空
+    cfs_rq_t rq;
+    rq_init(&rq);
+    for (i = 0; i < ntasks; i++)
+        tasks[i]->vruntime = rng_bounded(&rng, SCHED_LATENCY);
+    double t = GetTime();
+    for (i = 0; i < ntasks; i++)
+        enqueue(&rq, tasks[i]);
+    double enqueue_time = GetTime() - t;
+    assert(rb_check(&rq.tree, rq.tree.root) > 0);
+    t = GetTime();
+    long last = -1;
+    for (i = 0; i < ntasks; i++)
+    {
+        task_t *p = pick_next(&rq);
+        assert(p->vruntime >= last);
+        last = p->vruntime;
+    }
+    double pick_time = GetTime() - t;
+    assert(rq.tree.size == 0 && rq.tree.leftmost == NULL);
+
+    printf("tasks: %d\n", ntasks);
+    printf("enqueue:   %8.1f ns\n", enqueue_time / ntasks * 1e9);
+    printf("pick-next: %8.1f ns\n", pick_time / ntasks * 1e9);
+
+    // 2. 稳态调度：选最小 vruntime 运行一个时间片，然后重新入队或去睡眠
+    for (i = 0; i < ntasks; i++)
+    {
+        tasks[i]->vruntime = 0;
+        enqueue(&rq, tasks[i]);
+    }
+    task_t *sleepers[SLEEP_DECISIONS]; // 固定睡眠时长：一个环形延迟队列即可
+    int s;
+    for (s = 0; s < SLEEP_DECISIONS; s++)
+        sleepers[s] = NULL;
+    long now = 0, wakeups = 0;
+    long n;
+    t = GetTime();
+    for (n = 0; n < decisions; n++)
+    {
+        task_t *w = sleepers[n % SLEEP_DECISIONS];
+        if (w != NULL)
+        {
+            sleepers[n % SLEEP_DECISIONS] = NULL;
+            place_wakeup(&rq, w);
+            enqueue(&rq, w);
+            wakeups++;
+        }
+        task_t *curr = pick_next(&rq);
+        if (curr == NULL)
+            continue;
+        long slice = time_slice(&rq, curr);
+        now += slice;
+        account(&rq, curr, slice);
+        if (sleep_pct > 0 && rng_bounded(&rng, 100) < (uint64_t)sleep_pct &&
+            sleepers[n % SLEEP_DECISIONS] == NULL)
+            sleepers[n % SLEEP_DECISIONS] = curr;
+        else
+            enqueue(&rq, curr);
+    }
+    double loop_time = GetTime() - t;
+    assert(rb_check(&rq.tree, rq.tree.root) > 0);
+    printf("schedule:  %8.1f ns per decision (%ld decisions, %ld wakeups, sleep %d%%)\n",
+           loop_time / decisions * 1e9, decisions, wakeups, sleep_pct);
+    for (i = 0; i < ntasks; i++)
+        exec[i] = tasks[i]->sum_exec;
+    double cfs_err = share_error(exec, weight, ntasks);
+
+    // 3. 同一组权重、同样的总 CPU 时间，交给彩票调度（每次运行 MIN_GRANULARITY）；
+    //    睡眠/唤醒规则与 CFS 相同：中奖者以 sleep_pct 的概率睡 SLEEP_DECISIONS 次抽奖，
+    //    睡眠期间它的彩票从树中拿掉
+    fenwick_t f;
+    fenwick_init(&f, ntasks);
+    fenwick_build(&f, weight);
+    for (i = 0; i < ntasks; i++)
+        exec[i] = 0;
+    int lsleepers[SLEEP_DECISIONS];
+    for (s = 0; s < SLEEP_DECISIONS; s++)
+        lsleepers[s] = -1;
+    long draws = now / MIN_GRANULARITY;
+    t = GetTime();
+    for (n = 0; n < draws; n++)
+    {
+        int w = lsleepers[n % SLEEP_DECISIONS];
+        if (w >= 0)
+        {
+            lsleepers[n % SLEEP_DECISIONS] = -1;
+            fenwick_add(&f, w, weight[w]);
+        }
+        if (f.total == 0)
+            continue;
+        int winner = fenwick_find(&f, rng_bounded(&rng, f.total));
+        exec[winner] += MIN_GRANULARITY;
+        if (sleep_pct > 0 && rng_bounded(&rng, 100) < (uint64_t)sleep_pct &&
+            lsleepers[n % SLEEP_DECISIONS] < 0)
+        {
+            lsleepers[n % SLEEP_DECISIONS] = winner;
+            fenwick_add(&f, winner, -weight[winner]);
+        }
+    }
+    double lottery_time = GetTime() - t;
+    double lottery_err = share_error(exec, weight, ntasks);
+    fenwick_free(&f);
+
+    printf("\nfairness over %.1f s of simulated CPU time (share error, 0 = exact)\n", now / 1e9);
+    printf("cfs:     %.6f  (%.1f ns per decision)\n", cfs_err, loop_time / decisions * 1e9);
+    printf("lottery: %.6f  (%.1f ns per decision)\n", lottery_err, lottery_time / draws * 1e9);
+
+    for (i = 0; i < ntasks; i++)
+        task_release(tasks[i]);
+    free(tasks);
+    free(weight);
+    free(exec);
+    return 0;
+}
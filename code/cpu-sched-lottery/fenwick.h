@@ -0,0 +1,122 @@
+#ifndef __fenwick_h__
+#define __fenwick_h__
+
+// 数组实现的 Fenwick 树（树状数组），保存每个任务的彩票数
+// 与 lottery.c 中逐个遍历链表累加 tickets 相比：
+//   - 抽奖（找到前缀和首次超过 winner 的任务）：O(log n)
+//   - 修改某个任务的彩票数：O(log n)
+//   - 数据放在一段连续数组里，对缓存友好
+// 下标对外是 0 起（任务编号），内部 tree[] 按 1 起存放
+
+#include <stdlib.h>
+#include <assert.h>
+
+typedef struct
+{
+    int n;      // 任务数
+    int cap;    // tree[] 可容纳的任务数（fenwick_push 按倍数扩容）
+    int mask;   // 不超过 n 的最大 2 的幂，用于二进制倍增查找
+    long total; // 全部彩票数（对应 lottery.c 的 gtickets）
+    long *tree; // tree[i] 保存区间 (i - lowbit(i), i] 的彩票和
+} fenwick_t;
+
+#define LOWBIT(i) ((i) & -(i))
+
+void fenwick_init(fenwick_t *f, int n)
+{
+    f->n = n;
+    f->cap = n;
+    f->total = 0;
+    f->tree = calloc(n + 1, sizeof(long));
+    assert(f->tree != NULL);
+    f->mask = 1;
+    while (f->mask * 2 <= n)
+        f->mask *= 2;
+}
+
+void fenwick_free(fenwick_t *f)
+{
+    free(f->tree);
+    f->tree = NULL;
+}
+
+// O(n) 批量建树：先放入各自的值，再把每个节点累加到它的父节点
+void fenwick_build(fenwick_t *f, const int *tickets)
+{
+    int i;
+    f->total = 0;
+    for (i = 1; i <= f->n; i++)
+    {
+        f->tree[i] = tickets[i - 1];
+        f->total += tickets[i - 1];
+    }
+    for (i = 1; i <= f->n; i++)
+    {
+        int parent = i + LOWBIT(i);
+        if (parent <= f->n)
+            f->tree[parent] += f->tree[i];
+    }
+}
+
+// 任务 job 的彩票数增加 delta（可为负）
+void fenwick_add(fenwick_t *f, int job, long delta)
+{
+    int i;
+    for (i = job + 1; i <= f->n; i += LOWBIT(i))
+        f->tree[i] += delta;
+    f->total += delta;
+}
+
+// 任务 [0, job) 的彩票总和
+long fenwick_prefix(fenwick_t *f, int job)
+{
+    long sum = 0;
+    int i;
+    for (i = job; i > 0; i -= LOWBIT(i))
+        sum += f->tree[i];
+    return sum;
+}
+
+// 在末尾追加一个任务，返回其编号；均摊 O(log n)
+// 新节点 tree[i] 覆盖 (i - lowbit(i), i]，其中除自身外的部分都已在树中，可由两次前缀和求出
+int fenwick_push(fenwick_t *f, long tickets)
+{
+    if (f->n == f->cap)
+    {
+        f->cap = f->cap ? f->cap * 2 : 16;
+        f->tree = realloc(f->tree, sizeof(long) * (f->cap + 1));
+        assert(f->tree != NULL);
+    }
+    int i = ++f->n;
+    f->tree[i] = tickets + fenwick_prefix(f, i - 1) - fenwick_prefix(f, i - LOWBIT(i));
+    f->total += tickets;
+    while (f->mask * 2 <= f->n)
+        f->mask *= 2;
+    return i - 1;
+}
+
+// 单个任务当前的彩票数
+long fenwick_get(fenwick_t *f, int job)
+{
+    return fenwick_prefix(f, job + 1) - fenwick_prefix(f, job);
+}
+
+// 抽奖：返回前缀和首次 > winner 的任务编号（0 <= winner < total）
+// 与链表遍历 "counter > winner 则 break" 的语义完全一致
+int fenwick_find(fenwick_t *f, long winner)
+{
+    int pos = 0;
+    int step;
+    for (step = f->mask; step > 0; step >>= 1)
+    {
+        int next = pos + step;
+        if (next <= f->n && f->tree[next] <= winner)
+        {
+            pos = next;
+            winner -= f->tree[next];
+        }
+    }
+    return pos; // tree 1 起下标 pos + 1，对应任务编号 pos
+}
+
+#endif // __fenwick_h__
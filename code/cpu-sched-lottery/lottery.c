@@ -2,6 +2,8 @@
 #include <stdlib.h>
 #include <string.h>
 #include <assert.h>
+#include "rng.h"
+#include "slab.h"
 
 // global ticket count
 int gtickets = 0;
@@ -11,10 +13,13 @@ struct node_t {
     struct node_t *next;
 };
 
+// nodes come from a slab pool: packed together, no per-node malloc header
+SLAB_TYPE(node, struct node_t)
+
 struct node_t *head = NULL;
 
 void insert(int tickets) {
-    struct node_t *tmp = malloc(sizeof(struct node_t));
+    struct node_t *tmp = node_alloc();
     assert(tmp != NULL);
     tmp->tickets = tickets;
     tmp->next    = head;
@@ -41,7 +46,11 @@ main(int argc, char *argv[])
     }
     int seed  = atoi(argv[1]);
     int loops = atoi(argv[2]);
-    srandom(seed);
+
+    // xoshiro256++ streams seeded from <seed>: same seed, same draws
+    rng_bulk_t rng;
+    rng_bulk_seed(&rng, seed);
+    uint64_t winners[64];
 
     // populate list with some number of jobs, each
     // with some number of tickets
@@ -54,7 +63,10 @@ main(int argc, char *argv[])
     int i;
     for (i = 0; i < loops; i++) {
 	int counter            = 0;
-	int winner             = random() % gtickets; // get winner
+	// draw winners in batches; each is unbiased in [0, gtickets)
+	if (i % 64 == 0)
+	    draw_winners(&rng, gtickets, winners, 64);
+	int winner             = winners[i % 64]; // get winner
 	struct node_t *current = head;
 
 	// loop until the sum of ticket values is > the winner
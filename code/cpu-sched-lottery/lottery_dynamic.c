@@ -0,0 +1,88 @@
+// 动态彩票负载：任务不断到达和离开，同时穿插彩票转让、货币通胀和补偿彩票
+// 每个调度周期：抽出一个任务运行；它可能只用掉部分时间片（获得补偿彩票）；
+// 然后随机发生一个事件。所有事件都只做 O(log n) 的增量更新。
+// To compile: make lottery_dynamic
+// To run:     ./lottery_dynamic 1 16 100000 10000000
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+
+#include "common.h"
+#include "tickets.h"
+
+int main(int argc, char *argv[])
+{
+    if (argc != 5)
+    {
+        fprintf(stderr, "usage: lottery_dynamic <seed> <currencies> <jobs> <rounds>\n");
+        exit(1);
+    }
+    int seed = atoi(argv[1]);
+    int ncur = atoi(argv[2]);
+    int njobs = atoi(argv[3]);
+    long rounds = atol(argv[4]);
+    assert(ncur > 0 && njobs > 1 && rounds > 0);
+
+    rng_t rng;
+    rng_seed(&rng, seed);
+
+    lottery_t l;
+    lottery_init(&l, ncur, 1000);
+    int i;
+    for (i = 0; i < njobs; i++)
+        job_arrive(&l, rng_bounded(&rng, ncur), 1 + rng_bounded(&rng, 100));
+
+    long arrivals = 0, departures = 0, transfers = 0, inflations = 0, compensations = 0;
+    double t = GetTime();
+    long n;
+    for (n = 0; n < rounds; n++)
+    {
+        int job = lottery_draw(&l, &rng);
+
+        // 约三成的任务在时间片用完之前就因 I/O 让出了 CPU
+        if (rng_bounded(&rng, 10) < 3)
+        {
+            job_compensate(&l, job, 1 + rng_bounded(&rng, QUANTUM));
+            compensations++;
+        }
+
+        // 到达与离开的概率相同，任务总数在初始值附近波动
+        int r = rng_bounded(&rng, 100);
+        if (r < 20)
+        {
+            job_arrive(&l, rng_bounded(&rng, ncur), 1 + rng_bounded(&rng, 100));
+            arrivals++;
+        }
+        else if (r < 40 && l.nlive > 1)
+        {
+            job_depart(&l, l.live[rng_bounded(&rng, l.nlive)]);
+            departures++;
+        }
+        else if (r < 50)
+        {
+            int from = l.live[rng_bounded(&rng, l.nlive)];
+            int to = l.live[rng_bounded(&rng, l.nlive)];
+            if (from != to &&
+                job_transfer(&l, from, to, 1 + rng_bounded(&rng, l.jobs[from].tickets)) == 0)
+                transfers++;
+        }
+        else if (r < 52)
+        {
+            currency_inflate(&l, rng_bounded(&rng, ncur), 500 + rng_bounded(&rng, 1000));
+            inflations++;
+        }
+    }
+    double elapsed = GetTime() - t;
+
+    // 增量维护的结果必须与从头计算的一致
+    lottery_check(&l);
+
+    printf("rounds: %ld  live jobs: %d  currencies: %d\n", rounds, l.nlive, ncur);
+    printf("arrivals: %ld  departures: %ld  transfers: %ld  inflations: %ld  compensations: %ld\n",
+           arrivals, departures, transfers, inflations, compensations);
+    printf("%.0f rounds/sec (%.0f ns per draw + event)\n", rounds / elapsed, elapsed / rounds * 1e9);
+
+    lottery_free(&l);
+    return 0;
+}
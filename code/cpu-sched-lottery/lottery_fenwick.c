@@ -0,0 +1,127 @@
+// 彩票调度抽奖：链表遍历 O(n) 与 Fenwick 树 O(log n) 的对比
+// To compile: make lottery_fenwick
+// To run:     ./lottery_fenwick 1 100000 10
+//             ./lottery_fenwick 1 100000 10000
+//             ./lottery_fenwick 1 1000 1000000
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+
+#include "common.h"
+#include "fenwick.h"
+#include "rng.h"
+
+struct node_t
+{
+    int tickets;
+    int job; // 任务编号，便于和 Fenwick 树的结果对照
+    struct node_t *next;
+};
+
+struct node_t *head = NULL;
+struct node_t *tail = NULL;
+
+// 追加到表尾，使链表顺序与 Fenwick 树的下标顺序一致
+void append(int job, int tickets)
+{
+    struct node_t *tmp = malloc(sizeof(struct node_t));
+    assert(tmp != NULL);
+    tmp->tickets = tickets;
+    tmp->job = job;
+    tmp->next = NULL;
+    if (tail)
+        tail->next = tmp;
+    else
+        head = tmp;
+    tail = tmp;
+}
+
+// lottery.c 中的做法：从表头累加，直到超过 winner
+int list_find(long winner)
+{
+    long counter = 0;
+    struct node_t *current = head;
+    while (current)
+    {
+        counter = counter + current->tickets;
+        if (counter > winner)
+            break;
+        current = current->next;
+    }
+    return current->job;
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc != 4)
+    {
+        fprintf(stderr, "usage: lottery_fenwick <seed> <loops> <jobs>\n");
+        exit(1);
+    }
+    int seed = atoi(argv[1]);
+    int loops = atoi(argv[2]);
+    int jobs = atoi(argv[3]);
+    assert(loops > 0 && jobs > 0);
+    rng_t rng;
+    rng_seed(&rng, seed);
+
+    // 每个任务 1~100 张彩票
+    int *tickets = malloc(sizeof(int) * jobs);
+    assert(tickets != NULL);
+    long gtickets = 0;
+    int i;
+    for (i = 0; i < jobs; i++)
+    {
+        tickets[i] = 1 + rng_bounded(&rng, 100);
+        gtickets += tickets[i];
+        append(i, tickets[i]);
+    }
+
+    fenwick_t f;
+    fenwick_init(&f, jobs);
+    fenwick_build(&f, tickets);
+    assert(f.total == gtickets);
+
+    // 预先抽好所有中奖号码，两种方法使用完全相同的序列
+    uint64_t *winners = malloc(sizeof(uint64_t) * loops);
+    assert(winners != NULL);
+    rng_bulk_t bulk;
+    rng_bulk_seed(&bulk, seed);
+    draw_winners(&bulk, gtickets, winners, loops);
+
+    long check_list = 0, check_fen = 0;
+    double t = GetTime();
+    for (i = 0; i < loops; i++)
+        check_list += list_find(winners[i]);
+    double list_time = GetTime() - t;
+
+    t = GetTime();
+    for (i = 0; i < loops; i++)
+        check_fen += fenwick_find(&f, winners[i]);
+    double fen_time = GetTime() - t;
+
+    // 两种方法必须选出同一批中奖任务
+    assert(check_list == check_fen);
+
+    // 修改彩票数：Fenwick 树 O(log n) 更新
+    t = GetTime();
+    for (i = 0; i < loops; i++)
+    {
+        int job = winners[i] % jobs;
+        int newtickets = 1 + (winners[i] & 127);
+        fenwick_add(&f, job, newtickets - tickets[job]);
+        tickets[job] = newtickets;
+    }
+    double upd_time = GetTime() - t;
+
+    printf("jobs: %d  tickets: %ld  draws: %d\n", jobs, gtickets, loops);
+    printf("list walk : %12.0f draws/sec\n", loops / list_time);
+    printf("fenwick   : %12.0f draws/sec\n", loops / fen_time);
+    printf("fenwick   : %12.0f updates/sec\n", loops / upd_time);
+
+    fenwick_free(&f);
+    free(winners);
+    free(tickets);
+    return 0;
+}
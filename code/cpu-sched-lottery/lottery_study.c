@@ -0,0 +1,171 @@
+// 彩票调度公平性的并行蒙特卡洛实验（批处理模式，不打印调度过程）
+// 复现 lottery-fairness 图：两个彩票数相同、长度均为 L 的任务，
+// 不公平度 U = 先完成者的完成时间 / 后完成者的完成时间，对大量随机种子取平均
+//
+// 并行方式：
+//   - 每个线程一条独立的 xoshiro256++ 流（同一种子跳跃 k 次，互不重叠）
+//   - 每个长度的试验次数按线程静态均分，线程之间没有任何共享写
+//   - 每个线程把结果累加到自己的累加器里（按缓存行对齐，避免伪共享），最后由主线程合并
+// To compile: make lottery_study
+// To run:     ./lottery_study 1 100000 1000 0 fairness.csv
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include "common.h"
+#include "common_threads.h"
+#include "rng.h"
+
+#define MAX_LENGTHS 64
+
+// 单个长度的统计量，按 64 字节对齐：不同线程的累加器不会落在同一缓存行
+typedef struct
+{
+    double sum;
+    double sumsq;
+    long n;
+} __attribute__((aligned(64))) accum_t;
+
+typedef struct
+{
+    int id;
+    rng_t rng;
+    long trials; // 本线程在每个长度上负责的试验次数
+    accum_t acc[MAX_LENGTHS];
+} __attribute__((aligned(64))) worker_t;
+
+int lengths[MAX_LENGTHS];
+int nlengths;
+
+// 一次试验：两个任务各需 len 个时间片，每个时间片抛一次公平硬币决定谁运行
+// 64 位随机数的每一位都是一次抽奖（两任务彩票相同时 winner < 50% 等价于取一位）
+// 返回先完成者的完成时间；后完成者总在 2 * len 完成
+long first_finish(rng_t *r, int len)
+{
+    int done[2] = {0, 0};
+    long now = 0;
+    for (;;)
+    {
+        uint64_t bits = rng_next(r);
+        int b;
+        for (b = 0; b < 64; b++)
+        {
+            done[bits & 1]++;
+            bits >>= 1;
+            now++;
+            if (done[0] == len || done[1] == len)
+                return now;
+        }
+    }
+}
+
+void *worker(void *arg)
+{
+    worker_t *w = (worker_t *)arg;
+    int i;
+    long k;
+    for (i = 0; i < nlengths; i++)
+    {
+        accum_t a = {0, 0, 0}; // 先在局部变量里累加，最后写回一次
+        for (k = 0; k < w->trials; k++)
+        {
+            double u = (double)first_finish(&w->rng, lengths[i]) / (2.0 * lengths[i]);
+            a.sum += u;
+            a.sumsq += u * u;
+            a.n++;
+        }
+        w->acc[i] = a;
+    }
+    return NULL;
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc != 6)
+    {
+        fprintf(stderr, "usage: lottery_study <seed> <trials> <max-length> <threads> <out.csv>\n");
+        fprintf(stderr, "       threads = 0 uses every online CPU\n");
+        exit(1);
+    }
+    int seed = atoi(argv[1]);
+    long trials = atol(argv[2]);
+    int maxlen = atoi(argv[3]);
+    int nthreads = atoi(argv[4]);
+    char *outfile = argv[5];
+    assert(trials > 0 && maxlen > 0 && nthreads >= 0);
+    if (nthreads == 0)
+        nthreads = sysconf(_SC_NPROCESSORS_ONLN);
+
+    // 横轴取 1, 2, 5, 10, 20, 50, ... 直到 max-length（与原图的对数横轴一致）
+    int decade, m;
+    int mult[] = {1, 2, 5};
+    nlengths = 0;
+    for (decade = 1; decade <= maxlen && nlengths < MAX_LENGTHS; decade *= 10)
+        for (m = 0; m < 3; m++)
+            if (decade * mult[m] <= maxlen && nlengths < MAX_LENGTHS)
+                lengths[nlengths++] = decade * mult[m];
+
+    worker_t *workers;
+    int rc = posix_memalign((void **)&workers, 64, sizeof(worker_t) * nthreads);
+    assert(rc == 0);
+    pthread_t *threads = malloc(sizeof(pthread_t) * nthreads);
+    assert(threads != NULL);
+
+    // 为每个线程切出一条独立的流：第 i 个线程在种子流上跳 i + 1 次
+    rng_t base;
+    rng_seed(&base, seed);
+    int i;
+    for (i = 0; i < nthreads; i++)
+    {
+        rng_jump(&base);
+        workers[i].id = i;
+        workers[i].rng = base;
+        // 余数分给前几个线程，总试验次数恰好等于 trials
+        workers[i].trials = trials / nthreads + (i < trials % nthreads ? 1 : 0);
+    }
+
+    double t = GetTime();
+    for (i = 0; i < nthreads; i++)
+        Pthread_create(&threads[i], NULL, worker, &workers[i]);
+    for (i = 0; i < nthreads; i++)
+        Pthread_join(threads[i], NULL);
+    double elapsed = GetTime() - t;
+
+    FILE *out = fopen(outfile, "w");
+    if (out == NULL)
+    {
+        fprintf(stderr, "cannot open %s\n", outfile);
+        exit(1);
+    }
+    fprintf(out, "length,trials,mean_unfairness,stddev,stderr\n");
+    int l;
+    long total_trials = 0;
+    for (l = 0; l < nlengths; l++)
+    {
+        double sum = 0, sumsq = 0;
+        long n = 0;
+        for (i = 0; i < nthreads; i++)
+        {
+            sum += workers[i].acc[l].sum;
+            sumsq += workers[i].acc[l].sumsq;
+            n += workers[i].acc[l].n;
+        }
+        double mean = sum / n;
+        double var = (n > 1) ? (sumsq - n * mean * mean) / (n - 1) : 0.0;
+        double sd = var > 0 ? sqrt(var) : 0.0;
+        fprintf(out, "%d,%ld,%.6f,%.6f,%.6f\n", lengths[l], n, mean, sd, sd / sqrt(n));
+        total_trials += n;
+    }
+    fclose(out);
+
+    // 只输出一行汇总，便于脚本批量调用
+    fprintf(stderr, "%d threads, %ld trials in %.3f s (%.0f trials/sec) -> %s\n",
+            nthreads, total_trials, elapsed, total_trials / elapsed, outfile);
+
+    free(workers);
+    free(threads);
+    return 0;
+}
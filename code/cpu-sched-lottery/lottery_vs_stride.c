@@ -0,0 +1,147 @@
+// 彩票调度与步长调度并排对比
+//   第一部分：同一批任务（随机彩票数）上的调度吞吐量（每秒调度决策数）与份额误差
+//   第二部分：复现 lottery-fairness 图中的不公平度 U = 先完成任务的完成时间 / 后完成任务的完成时间
+//             两个任务彩票数相同、长度均为 L，U 越接近 1 越公平
+// To compile: make lottery_vs_stride
+// To run:     ./lottery_vs_stride 1 10000 1000000 100
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+
+#include "common.h"
+#include "fenwick.h"
+#include "stride.h"
+#include "rng.h"
+
+rng_t rng;
+
+// 份额误差：实际调度次数占比与彩票占比之间的总变差距离（0 表示完全按比例）
+double share_error(long *counts, int *tickets, int jobs, long total_tickets, long loops)
+{
+    double err = 0.0;
+    int i;
+    for (i = 0; i < jobs; i++)
+    {
+        double got = (double)counts[i] / loops;
+        double want = (double)tickets[i] / total_tickets;
+        err += (got > want) ? got - want : want - got;
+    }
+    return err / 2;
+}
+
+void throughput(int jobs, long loops)
+{
+    int *tickets = calloc(jobs, sizeof(int));
+    long *counts = calloc(jobs, sizeof(long));
+    assert(tickets != NULL && counts != NULL);
+    long total = 0;
+    int i;
+    for (i = 0; i < jobs; i++)
+    {
+        tickets[i] = 1 + rng_bounded(&rng, 100);
+        total += tickets[i];
+    }
+
+    // 彩票调度：Fenwick 树上抽奖
+    fenwick_t f;
+    fenwick_init(&f, jobs);
+    fenwick_build(&f, tickets);
+    double t = GetTime();
+    long n;
+    for (n = 0; n < loops; n++)
+        counts[fenwick_find(&f, rng_bounded(&rng, f.total))]++;
+    double lottery_time = GetTime() - t;
+    double lottery_err = share_error(counts, tickets, jobs, total, loops);
+    fenwick_free(&f);
+
+    // 步长调度：最小堆上取 pass 最小者
+    for (i = 0; i < jobs; i++)
+        counts[i] = 0;
+    stride_t s;
+    stride_init(&s, jobs);
+    for (i = 0; i < jobs; i++)
+        stride_insert(&s, i, tickets[i]);
+    t = GetTime();
+    for (n = 0; n < loops; n++)
+        counts[stride_next(&s)]++;
+    double stride_time = GetTime() - t;
+    double stride_err = share_error(counts, tickets, jobs, total, loops);
+    stride_free(&s);
+
+    printf("jobs: %d  decisions: %ld\n", jobs, loops);
+    printf("%-8s %16s %12s\n", "policy", "decisions/sec", "share-error");
+    printf("%-8s %16.0f %12.6f\n", "lottery", loops / lottery_time, lottery_err);
+    printf("%-8s %16.0f %12.6f\n", "stride", loops / stride_time, stride_err);
+
+    free(tickets);
+    free(counts);
+}
+
+// 两个同为 100 张彩票、长度为 len 的任务：返回先完成者的完成时间
+// 后完成者总在 2 * len 时完成（CPU 从不空闲），因此 U = first / (2 * len)
+long first_finish_lottery(int len)
+{
+    int done[2] = {0, 0};
+    long now = 0;
+    while (done[0] < len && done[1] < len)
+    {
+        done[rng_bounded(&rng, 200) < 100 ? 0 : 1]++;
+        now++;
+    }
+    return now;
+}
+
+long first_finish_stride(int len)
+{
+    int done[2] = {0, 0};
+    long now = 0;
+    stride_t s;
+    stride_init(&s, 2);
+    stride_insert(&s, 0, 100);
+    stride_insert(&s, 1, 100);
+    while (done[0] < len && done[1] < len)
+    {
+        done[stride_next(&s)]++;
+        now++;
+    }
+    stride_free(&s);
+    return now;
+}
+
+void fairness(int trials)
+{
+    int lens[] = {1, 2, 5, 10, 20, 50, 100, 200, 500, 1000};
+    int nlens = sizeof(lens) / sizeof(lens[0]);
+    printf("\nunfairness (two jobs, equal tickets, %d trials)\n", trials);
+    printf("%8s %10s %10s\n", "length", "lottery", "stride");
+    int i, k;
+    for (i = 0; i < nlens; i++)
+    {
+        double ulottery = 0, ustride = 0;
+        for (k = 0; k < trials; k++)
+            ulottery += (double)first_finish_lottery(lens[i]) / (2.0 * lens[i]);
+        // 步长调度是确定性的，一次即可
+        ustride = (double)first_finish_stride(lens[i]) / (2.0 * lens[i]);
+        printf("%8d %10.4f %10.4f\n", lens[i], ulottery / trials, ustride);
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc != 5)
+    {
+        fprintf(stderr, "usage: lottery_vs_stride <seed> <jobs> <loops> <trials>\n");
+        exit(1);
+    }
+    int seed = atoi(argv[1]);
+    int jobs = atoi(argv[2]);
+    long loops = atol(argv[3]);
+    int trials = atoi(argv[4]);
+    assert(jobs > 0 && loops > 0 && trials > 0);
+    rng_seed(&rng, seed);
+
+    throughput(jobs, loops);
+    fairness(trials);
+    return 0;
+}
@@ -0,0 +1,170 @@
+#ifndef __propshare_h__
+#define __propshare_h__
+
+// 用户态比例份额调度运行时：用彩票或步长策略真正地控制一组 pthread 工作线程
+//
+// 每个工作线程有一个私有信号量作为"运行令牌"，平时阻塞在上面；
+// 调度线程每个时间片选出一个工作线程，发给它令牌，然后等它交回 CPU。
+// 同一时刻最多只有一个工作线程在运行，因此各线程得到的 CPU 份额完全由策略决定。
+//
+// 计时（单位 ns）：
+//   run      - 工作线程拿到令牌后实际运行的时间
+//   overhead - 调度线程发出令牌到工作线程开始运行、工作线程让出到调度线程醒来，两段之和
+
+#include <stdlib.h>
+#include <time.h>
+#include <semaphore.h>
+#include <pthread.h>
+
+#include "common_threads.h"
+#include "fenwick.h"
+#include "stride.h"
+#include "rng.h"
+
+typedef enum
+{
+    PS_LOTTERY,
+    PS_STRIDE
+} ps_policy_t;
+
+struct __ps_runtime_t;
+
+typedef struct
+{
+    int id;
+    int tickets;
+    sem_t run;           // 运行令牌
+    pthread_t thread;
+    struct __ps_runtime_t *rt;
+    void (*work)(void *); // 一个工作单元；在一个时间片内反复调用
+    void *arg;
+    long quanta;          // 获得的时间片数
+    long run_ns;          // 实际运行时间
+    long cpu_ns;          // 线程 CPU 时间（CLOCK_THREAD_CPUTIME_ID）
+    long start_ns;        // 本次时间片开始运行的时刻
+    long end_ns;          // 本次时间片让出的时刻
+} ps_worker_t;
+
+typedef struct __ps_runtime_t
+{
+    ps_policy_t policy;
+    int n;
+    ps_worker_t *workers;
+    long quantum_ns;
+    sem_t yield;          // 工作线程交回 CPU 时发出
+    volatile int stop;
+    fenwick_t lottery;
+    stride_t stride;
+    rng_t rng;
+    long dispatches;
+    long overhead_ns;
+} ps_runtime_t;
+
+long ps_now(clockid_t clock)
+{
+    struct timespec ts;
+    int rc = clock_gettime(clock, &ts);
+    assert(rc == 0);
+    return ts.tv_sec * 1000000000L + ts.tv_nsec;
+}
+
+// 工作线程：等令牌 -> 运行一个时间片 -> 交回 CPU
+void *ps_worker_main(void *arg)
+{
+    ps_worker_t *w = (ps_worker_t *)arg;
+    ps_runtime_t *rt = w->rt;
+    for (;;)
+    {
+        Sem_wait(&w->run);
+        if (rt->stop)
+            break;
+        w->start_ns = ps_now(CLOCK_MONOTONIC);
+        long deadline = w->start_ns + rt->quantum_ns;
+        long now;
+        do
+        {
+            w->work(w->arg);
+            now = ps_now(CLOCK_MONOTONIC);
+        } while (now < deadline);
+        w->end_ns = now;
+        w->run_ns += now - w->start_ns;
+        w->quanta++;
+        Sem_post(&rt->yield);
+    }
+    w->cpu_ns = ps_now(CLOCK_THREAD_CPUTIME_ID);
+    return NULL;
+}
+
+void ps_init(ps_runtime_t *rt, ps_policy_t policy, long quantum_ns, int n, uint64_t seed)
+{
+    rt->policy = policy;
+    rt->n = n;
+    rt->quantum_ns = quantum_ns;
+    rt->stop = 0;
+    rt->dispatches = 0;
+    rt->overhead_ns = 0;
+    rt->workers = calloc(n, sizeof(ps_worker_t));
+    assert(rt->workers != NULL);
+    Sem_init(&rt->yield, 0);
+    fenwick_init(&rt->lottery, n);
+    stride_init(&rt->stride, n);
+    rng_seed(&rt->rng, seed);
+}
+
+// 登记第 id 个工作线程及其彩票数，并启动它（启动后立即阻塞在令牌上）
+void ps_spawn(ps_runtime_t *rt, int id, int tickets, void (*work)(void *), void *arg)
+{
+    ps_worker_t *w = &rt->workers[id];
+    w->id = id;
+    w->tickets = tickets;
+    w->rt = rt;
+    w->work = work;
+    w->arg = arg;
+    Sem_init(&w->run, 0);
+    fenwick_add(&rt->lottery, id, tickets);
+    stride_insert(&rt->stride, id, tickets);
+    Pthread_create(&w->thread, NULL, ps_worker_main, w);
+}
+
+int ps_pick(ps_runtime_t *rt)
+{
+    if (rt->policy == PS_LOTTERY)
+        return fenwick_find(&rt->lottery, rng_bounded(&rt->rng, rt->lottery.total));
+    return stride_next(&rt->stride);
+}
+
+// 调度循环：分发 quanta 个时间片
+void ps_run(ps_runtime_t *rt, long quanta)
+{
+    long q;
+    for (q = 0; q < quanta; q++)
+    {
+        ps_worker_t *w = &rt->workers[ps_pick(rt)];
+        long sent = ps_now(CLOCK_MONOTONIC);
+        Sem_post(&w->run);
+        Sem_wait(&rt->yield);
+        long back = ps_now(CLOCK_MONOTONIC);
+        rt->overhead_ns += (w->start_ns - sent) + (back - w->end_ns);
+        rt->dispatches++;
+    }
+}
+
+// 停止所有工作线程并回收
+void ps_shutdown(ps_runtime_t *rt)
+{
+    int i;
+    rt->stop = 1;
+    for (i = 0; i < rt->n; i++)
+        Sem_post(&rt->workers[i].run);
+    for (i = 0; i < rt->n; i++)
+        Pthread_join(rt->workers[i].thread, NULL);
+}
+
+void ps_destroy(ps_runtime_t *rt)
+{
+    fenwick_free(&rt->lottery);
+    stride_free(&rt->stride);
+    free(rt->workers);
+}
+
+#endif // __propshare_h__
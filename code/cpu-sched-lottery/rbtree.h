@@ -0,0 +1,307 @@
+#ifndef __rbtree_h__
+#define __rbtree_h__
+
+// 侵入式红黑树（算法取自 CLRS 第 13 章，使用哨兵节点 nil）
+// 节点结构 rb_node_t 嵌入在调用者自己的结构体中，树本身不分配内存；
+// 额外缓存最左节点，取最小元素 O(1)（CFS 每次都取 vruntime 最小的任务）
+
+#include <stddef.h>
+
+typedef struct rb_node_t
+{
+    struct rb_node_t *left;
+    struct rb_node_t *right;
+    struct rb_node_t *parent;
+    int red;
+} rb_node_t;
+
+typedef struct
+{
+    rb_node_t *root;
+    rb_node_t *leftmost;                      // 最小节点，空树时为 NULL
+    rb_node_t nil;                            // 哨兵：所有叶子与根的父节点都指向它
+    int (*less)(rb_node_t *a, rb_node_t *b);  // 严格弱序
+    long size;
+} rb_tree_t;
+
+// 由嵌入的节点指针得到外层结构体指针
+#define rb_entry(ptr, type, member) ((type *)((char *)(ptr) - offsetof(type, member)))
+
+void rb_init(rb_tree_t *t, int (*less)(rb_node_t *, rb_node_t *))
+{
+    t->nil.left = t->nil.right = t->nil.parent = &t->nil;
+    t->nil.red = 0;
+    t->root = &t->nil;
+    t->leftmost = NULL;
+    t->less = less;
+    t->size = 0;
+}
+
+void rb_rotate_left(rb_tree_t *t, rb_node_t *x)
+{
+    rb_node_t *y = x->right;
+    x->right = y->left;
+    if (y->left != &t->nil)
+        y->left->parent = x;
+    y->parent = x->parent;
+    if (x->parent == &t->nil)
+        t->root = y;
+    else if (x == x->parent->left)
+        x->parent->left = y;
+    else
+        x->parent->right = y;
+    y->left = x;
+    x->parent = y;
+}
+
+void rb_rotate_right(rb_tree_t *t, rb_node_t *x)
+{
+    rb_node_t *y = x->left;
+    x->left = y->right;
+    if (y->right != &t->nil)
+        y->right->parent = x;
+    y->parent = x->parent;
+    if (x->parent == &t->nil)
+        t->root = y;
+    else if (x == x->parent->right)
+        x->parent->right = y;
+    else
+        x->parent->left = y;
+    y->right = x;
+    x->parent = y;
+}
+
+void rb_insert(rb_tree_t *t, rb_node_t *z)
+{
+    rb_node_t *y = &t->nil;
+    rb_node_t *x = t->root;
+    while (x != &t->nil)
+    {
+        y = x;
+        x = t->less(z, x) ? x->left : x->right;
+    }
+    z->parent = y;
+    if (y == &t->nil)
+        t->root = z;
+    else if (t->less(z, y))
+        y->left = z;
+    else
+        y->right = z;
+    z->left = z->right = &t->nil;
+    z->red = 1;
+    if (t->leftmost == NULL || t->less(z, t->leftmost))
+        t->leftmost = z;
+    t->size++;
+
+    // 修复：消除连续的红节点
+    while (z->parent->red)
+    {
+        rb_node_t *gp = z->parent->parent;
+        if (z->parent == gp->left)
+        {
+            rb_node_t *uncle = gp->right;
+            if (uncle->red)
+            {
+                z->parent->red = 0;
+                uncle->red = 0;
+                gp->red = 1;
+                z = gp;
+            }
+            else
+            {
+                if (z == z->parent->right)
+                {
+                    z = z->parent;
+                    rb_rotate_left(t, z);
+                }
+                z->parent->red = 0;
+                z->parent->parent->red = 1;
+                rb_rotate_right(t, z->parent->parent);
+            }
+        }
+        else
+        {
+            rb_node_t *uncle = gp->left;
+            if (uncle->red)
+            {
+                z->parent->red = 0;
+                uncle->red = 0;
+                gp->red = 1;
+                z = gp;
+            }
+            else
+            {
+                if (z == z->parent->left)
+                {
+                    z = z->parent;
+                    rb_rotate_right(t, z);
+                }
+                z->parent->red = 0;
+                z->parent->parent->red = 1;
+                rb_rotate_left(t, z->parent->parent);
+            }
+        }
+    }
+    t->root->red = 0;
+}
+
+rb_node_t *rb_min(rb_tree_t *t, rb_node_t *x)
+{
+    while (x->left != &t->nil)
+        x = x->left;
+    return x;
+}
+
+// 中序后继；没有后继时返回 NULL
+rb_node_t *rb_next(rb_tree_t *t, rb_node_t *x)
+{
+    if (x->right != &t->nil)
+        return rb_min(t, x->right);
+    rb_node_t *y = x->parent;
+    while (y != &t->nil && x == y->right)
+    {
+        x = y;
+        y = y->parent;
+    }
+    return y == &t->nil ? NULL : y;
+}
+
+void rb_transplant(rb_tree_t *t, rb_node_t *u, rb_node_t *v)
+{
+    if (u->parent == &t->nil)
+        t->root = v;
+    else if (u == u->parent->left)
+        u->parent->left = v;
+    else
+        u->parent->right = v;
+    v->parent = u->parent;
+}
+
+void rb_erase(rb_tree_t *t, rb_node_t *z)
+{
+    if (z == t->leftmost)
+        t->leftmost = rb_next(t, z);
+    t->size--;
+
+    rb_node_t *y = z;
+    rb_node_t *x;
+    int y_red = y->red;
+    if (z->left == &t->nil)
+    {
+        x = z->right;
+        rb_transplant(t, z, z->right);
+    }
+    else if (z->right == &t->nil)
+    {
+        x = z->left;
+        rb_transplant(t, z, z->left);
+    }
+    else
+    {
+        y = rb_min(t, z->right);
+        y_red = y->red;
+        x = y->right;
+        if (y->parent == z)
+            x->parent = y;
+        else
+        {
+            rb_transplant(t, y, y->right);
+            y->right = z->right;
+            y->right->parent = y;
+        }
+        rb_transplant(t, z, y);
+        y->left = z->left;
+        y->left->parent = y;
+        y->red = z->red;
+    }
+    if (y_red)
+        return;
+
+    // 修复：删掉一个黑节点后补齐黑高
+    while (x != t->root && !x->red)
+    {
+        if (x == x->parent->left)
+        {
+            rb_node_t *w = x->parent->right;
+            if (w->red)
+            {
+                w->red = 0;
+                x->parent->red = 1;
+                rb_rotate_left(t, x->parent);
+                w = x->parent->right;
+            }
+            if (!w->left->red && !w->right->red)
+            {
+                w->red = 1;
+                x = x->parent;
+            }
+            else
+            {
+                if (!w->right->red)
+                {
+                    w->left->red = 0;
+                    w->red = 1;
+                    rb_rotate_right(t, w);
+                    w = x->parent->right;
+                }
+                w->red = x->parent->red;
+                x->parent->red = 0;
+                w->right->red = 0;
+                rb_rotate_left(t, x->parent);
+                x = t->root;
+            }
+        }
+        else
+        {
+            rb_node_t *w = x->parent->left;
+            if (w->red)
+            {
+                w->red = 0;
+                x->parent->red = 1;
+                rb_rotate_right(t, x->parent);
+                w = x->parent->left;
+            }
+            if (!w->right->red && !w->left->red)
+            {
+                w->red = 1;
+                x = x->parent;
+            }
+            else
+            {
+                if (!w->left->red)
+                {
+                    w->right->red = 0;
+                    w->red = 1;
+                    rb_rotate_left(t, w);
+                    w = x->parent->left;
+                }
+                w->red = x->parent->red;
+                x->parent->red = 0;
+                w->left->red = 0;
+                rb_rotate_right(t, x->parent);
+                x = t->root;
+            }
+        }
+    }
+    x->red = 0;
+}
+
+// 校验红黑性质，返回黑高；用于测试
+int rb_check(rb_tree_t *t, rb_node_t *x)
+{
+    if (x == &t->nil)
+        return 1;
+    if (x->red && (x->left->red || x->right->red))
+        return -1;
+    if (x->left != &t->nil && t->less(x, x->left))
+        return -1;
+    if (x->right != &t->nil && t->less(x->right, x))
+        return -1;
+    int l = rb_check(t, x->left);
+    int r = rb_check(t, x->right);
+    if (l < 0 || r < 0 || l != r)
+        return -1;
+    return l + (x->red ? 0 : 1);
+}
+
+#endif // __rbtree_h__
@@ -0,0 +1,187 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#include "rng.h"
+#include "cycles.h"
+#include "slab.h"
+
+// malloc vs the slab pool in slab.h for lottery.c's job list nodes.
+//
+// 1. latency: allocate a batch of BATCH nodes, then free them; every batch is
+//    timed with the cycle counter and reported per operation
+// 2. locality: build a list of <nodes> nodes while the rest of the program keeps
+//    allocating other objects (one 16..256-byte filler per node, left alive),
+//    then walk it like a lottery draw. malloc interleaves the nodes with the
+//    fillers and their headers; the slab packs four nodes per cache line.
+//    Cache misses come from perf_event_open; "n/a" when it is not permitted.
+//
+// usage: slab_bench [nodes] [walks]
+
+#define BATCH  64
+#define ROUNDS 20000
+
+struct node_t {
+    int            tickets;
+    struct node_t *next;
+};
+
+SLAB_TYPE(node, struct node_t)
+SLAB_TYPE_CACHED(cnode, struct node_t)
+
+enum { USE_MALLOC, USE_SLAB, USE_CACHED };
+const char *names[] = {"malloc", "slab", "slab-cached"};
+
+struct node_t *
+alloc_node(int how)
+{
+    switch (how) {
+    case USE_SLAB:   return node_alloc();
+    case USE_CACHED: return cnode_alloc();
+    default:         return malloc(sizeof(struct node_t));
+    }
+}
+
+void
+free_node(int how, struct node_t *n)
+{
+    switch (how) {
+    case USE_SLAB:   node_free(n); break;
+    case USE_CACHED: cnode_free(n); break;
+    default:         free(n);
+    }
+}
+
+void
+latency(int how)
+{
+    struct node_t *batch[BATCH];
+    uint64_t *a = malloc(ROUNDS * sizeof(uint64_t));
+    uint64_t *f = malloc(ROUNDS * sizeof(uint64_t));
+    assert(a != NULL && f != NULL);
+    int r, i;
+    for (r = 0; r < ROUNDS; r++) {
+	uint64_t t0 = cycles_now();
+	for (i = 0; i < BATCH; i++)
+	    batch[i] = alloc_node(how);
+	uint64_t t1 = cycles_now();
+	for (i = 0; i < BATCH; i++)
+	    free_node(how, batch[i]);
+	uint64_t t2 = cycles_now();
+	a[r] = t1 - t0;
+	f[r] = t2 - t1;
+    }
+    char name[64];
+    snprintf(name, sizeof(name), "%s alloc", names[how]);
+    cycles_report(name, a, ROUNDS, BATCH);
+    snprintf(name, sizeof(name), "%s free", names[how]);
+    cycles_report(name, f, ROUNDS, BATCH);
+    free(a);
+    free(f);
+}
+
+int
+open_miss_counter(void)
+{
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size           = sizeof(attr);
+    attr.type           = PERF_TYPE_HARDWARE;
+    attr.config         = PERF_COUNT_HW_CACHE_MISSES;
+    attr.disabled       = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv     = 1;
+    return syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+void
+locality(int how, long nodes, int walks, int fd)
+{
+    rng_t rng;
+    rng_seed(&rng, 1);
+    char **filler = malloc(nodes * sizeof(char *));
+    assert(filler != NULL);
+    struct node_t *head = NULL;
+    long i, gtickets = 0;
+    for (i = 0; i < nodes; i++) {
+	struct node_t *n = alloc_node(how);
+	assert(n != NULL);
+	n->tickets = 1 + rng_bounded(&rng, 100);
+	n->next    = head;
+	head       = n;
+	gtickets  += n->tickets;
+	filler[i]  = malloc(16 + rng_bounded(&rng, 241));
+	assert(filler[i] != NULL);
+    }
+
+    // each walk looks for a random winner, as lottery.c does
+    long sum = 0, visited = 0;
+    long long misses = 0;
+    if (fd >= 0) {
+	ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+	ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+    }
+    uint64_t t = cycles_now();
+    int w;
+    for (w = 0; w < walks; w++) {
+	long winner = rng_bounded(&rng, gtickets), counter = 0;
+	struct node_t *cur;
+	for (cur = head; cur != NULL; cur = cur->next) {
+	    visited++;
+	    counter += cur->tickets;
+	    if (counter > winner)
+		break;
+	}
+	sum += cur->tickets;
+    }
+    t = cycles_now() - t;
+    if (fd >= 0) {
+	ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+	if (read(fd, &misses, sizeof(misses)) != sizeof(misses))
+	    misses = -1;
+    }
+
+    printf("%-12s %12.2f", names[how], cycles_to_ns(t) / visited);
+    if (fd >= 0 && misses >= 0)
+	printf(" %14.3f\n", (double) misses / visited);
+    else
+	printf(" %14s\n", "n/a");
+    assert(sum > 0);
+
+    while (head != NULL) {
+	struct node_t *next = head->next;
+	free_node(how, head);
+	head = next;
+    }
+    for (i = 0; i < nodes; i++)
+	free(filler[i]);
+    free(filler);
+}
+
+int
+main(int argc, char *argv[])
+{
+    long nodes = argc > 1 ? atol(argv[1]) : 1000000;
+    int walks  = argc > 2 ? atoi(argv[2]) : 50;
+    assert(nodes > 0 && walks > 0);
+    cycles_calibrate(100);
+
+    printf("latency per operation (ns), batches of %d, %d rounds\n", BATCH, ROUNDS);
+    cycles_report_header();
+    int how;
+    for (how = USE_MALLOC; how <= USE_CACHED; how++)
+	latency(how);
+
+    printf("\nlist walk over %ld nodes, %d walks\n", nodes, walks);
+    printf("%-12s %12s %14s\n", "allocator", "ns/node", "misses/node");
+    int fd = open_miss_counter();
+    for (how = USE_MALLOC; how <= USE_CACHED; how++)
+	locality(how, nodes, walks, fd);
+    if (fd >= 0)
+	close(fd);
+    return 0;
+}
@@ -0,0 +1,114 @@
+#ifndef __stride_h__
+#define __stride_h__
+
+// 步长调度（stride scheduling）：确定性的比例份额调度
+// 每个任务的 stride = STRIDE_BIG / tickets，pass 初始为 0
+// 每次调度选 pass 最小的任务运行，然后 pass += stride
+// pass 值保存在二叉最小堆中：选出下一个任务 O(1)，运行后调整 O(log n)
+
+#include <stdlib.h>
+#include <assert.h>
+
+#define STRIDE_BIG (1L << 20) // 大常数，越大 stride 的整数截断误差越小
+
+typedef struct
+{
+    long pass;   // 已"走过"的距离
+    long stride; // 每运行一次前进的步长
+    int job;     // 任务编号
+} stride_entry_t;
+
+typedef struct
+{
+    int n;
+    int cap;
+    stride_entry_t *heap;
+} stride_t;
+
+void stride_init(stride_t *s, int cap)
+{
+    s->n = 0;
+    s->cap = cap;
+    s->heap = malloc(sizeof(stride_entry_t) * cap);
+    assert(s->heap != NULL);
+}
+
+void stride_free(stride_t *s)
+{
+    free(s->heap);
+    s->heap = NULL;
+}
+
+// 堆序：pass 小者优先；pass 相同则按任务编号，保证结果完全确定
+int stride_less(stride_entry_t *a, stride_entry_t *b)
+{
+    if (a->pass != b->pass)
+        return a->pass < b->pass;
+    return a->job < b->job;
+}
+
+void stride_sift_up(stride_t *s, int i)
+{
+    stride_entry_t e = s->heap[i];
+    while (i > 0)
+    {
+        int parent = (i - 1) / 2;
+        if (!stride_less(&e, &s->heap[parent]))
+            break;
+        s->heap[i] = s->heap[parent];
+        i = parent;
+    }
+    s->heap[i] = e;
+}
+
+void stride_sift_down(stride_t *s, int i)
+{
+    stride_entry_t e = s->heap[i];
+    for (;;)
+    {
+        int child = 2 * i + 1;
+        if (child >= s->n)
+            break;
+        if (child + 1 < s->n && stride_less(&s->heap[child + 1], &s->heap[child]))
+            child++;
+        if (!stride_less(&s->heap[child], &e))
+            break;
+        s->heap[i] = s->heap[child];
+        i = child;
+    }
+    s->heap[i] = e;
+}
+
+// 加入任务：新任务从当前最小 pass 出发，避免它靠过小的 pass 长时间独占 CPU
+void stride_insert(stride_t *s, int job, int tickets)
+{
+    assert(tickets > 0);
+    assert(s->n < s->cap);
+    stride_entry_t *e = &s->heap[s->n];
+    e->pass = (s->n > 0) ? s->heap[0].pass : 0;
+    e->stride = STRIDE_BIG / tickets;
+    e->job = job;
+    s->n++;
+    stride_sift_up(s, s->n - 1);
+}
+
+// 选出下一个运行的任务，并让它前进一个 stride
+int stride_next(stride_t *s)
+{
+    assert(s->n > 0);
+    int job = s->heap[0].job;
+    s->heap[0].pass += s->heap[0].stride;
+    stride_sift_down(s, 0);
+    return job;
+}
+
+// 移除堆顶任务（例如该任务运行结束）
+void stride_remove_top(stride_t *s)
+{
+    assert(s->n > 0);
+    s->heap[0] = s->heap[--s->n];
+    if (s->n > 0)
+        stride_sift_down(s, 0);
+}
+
+#endif // __stride_h__
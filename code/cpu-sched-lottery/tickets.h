@@ -0,0 +1,259 @@
+#ifndef __tickets_h__
+#define __tickets_h__
+
+// 动态彩票管理：任务的到达/离开、彩票转让、货币与通胀、补偿彩票
+// 所有操作都在 Fenwick 树上做增量更新，不重建选择结构
+//
+// 两级结构：
+//   顶层 Fenwick 树：每种货币一项，权重 = 该货币的基础彩票资金（没有存活任务时为 0）
+//   每种货币一棵 Fenwick 树：其中每个任务一项，权重 = 以该货币计的有效彩票数
+// 抽奖时先按资金选货币，再在货币内部按彩票选任务，因此
+//   P(任务 j) = funding(c) / Σfunding × eff(j) / Σ_c eff
+// 正好是"以货币计的彩票按汇率换算成基础彩票"后的份额
+//
+//   操作                     代价
+//   抽奖                     O(log C + log n)
+//   到达 / 离开              O(log n)（槽位回收复用，数组按倍数扩容）
+//   同一货币内的彩票转让     O(log n)
+//   货币通胀（改变资金）     O(log C)，该货币内所有任务的基础价值同时按比例变化
+//   补偿彩票                 O(log n)
+
+#include <stdlib.h>
+#include <assert.h>
+
+#include "fenwick.h"
+#include "rng.h"
+
+#define QUANTUM 1000 // 一个完整时间片的长度（补偿彩票按已用部分的比例计算）
+
+typedef struct
+{
+    long funding;  // 以基础货币计的资金
+    fenwick_t eff; // 每个槽位上任务的有效彩票数
+    int *slot_job; // 槽位 -> 任务编号
+    int *free_slots;
+    int nfree;
+    int live;      // 存活任务数
+} currency_t;
+
+typedef struct
+{
+    int currency;
+    int slot;
+    long tickets;  // 以所属货币计的面值
+    long eff;      // 有效彩票数 = tickets，或因补偿而放大后的值
+    int pos;       // 在 live[] 中的位置，-1 表示已离开
+} job_t;
+
+typedef struct
+{
+    fenwick_t top;
+    currency_t *cur;
+    int ncur;
+    job_t *jobs;
+    int njobs;
+    int capjobs;
+    int *free_jobs; // 已离开任务的编号，供新任务复用
+    int nfree;
+    int *live;      // 存活任务编号的紧凑数组，便于随机挑选
+    int nlive;
+} lottery_t;
+
+void lottery_init(lottery_t *l, int ncurrencies, long funding)
+{
+    int i;
+    fenwick_init(&l->top, ncurrencies);
+    l->cur = calloc(ncurrencies, sizeof(currency_t));
+    assert(l->cur != NULL);
+    l->ncur = ncurrencies;
+    for (i = 0; i < ncurrencies; i++)
+    {
+        l->cur[i].funding = funding;
+        fenwick_init(&l->cur[i].eff, 0);
+    }
+    l->jobs = NULL;
+    l->njobs = l->capjobs = 0;
+    l->free_jobs = NULL;
+    l->nfree = 0;
+    l->live = NULL;
+    l->nlive = 0;
+}
+
+void lottery_free(lottery_t *l)
+{
+    int i;
+    for (i = 0; i < l->ncur; i++)
+    {
+        fenwick_free(&l->cur[i].eff);
+        free(l->cur[i].slot_job);
+        free(l->cur[i].free_slots);
+    }
+    fenwick_free(&l->top);
+    free(l->cur);
+    free(l->jobs);
+    free(l->free_jobs);
+    free(l->live);
+}
+
+// 货币在顶层树中的权重：没有存活任务的货币不能中奖
+void currency_sync(lottery_t *l, int c)
+{
+    currency_t *cur = &l->cur[c];
+    long want = cur->live > 0 ? cur->funding : 0;
+    long have = fenwick_get(&l->top, c);
+    if (want != have)
+        fenwick_add(&l->top, c, want - have);
+}
+
+// 设置任务的有效彩票数（增量更新所在货币的树）
+void job_set_eff(lottery_t *l, int job, long eff)
+{
+    job_t *j = &l->jobs[job];
+    fenwick_add(&l->cur[j->currency].eff, j->slot, eff - j->eff);
+    j->eff = eff;
+}
+
+// 新任务到达：返回任务编号
+int job_arrive(lottery_t *l, int c, long tickets)
+{
+    assert(c >= 0 && c < l->ncur && tickets > 0);
+    int job;
+    if (l->nfree > 0)
+        job = l->free_jobs[--l->nfree];
+    else
+    {
+        if (l->njobs == l->capjobs)
+        {
+            l->capjobs = l->capjobs ? l->capjobs * 2 : 1024;
+            l->jobs = realloc(l->jobs, sizeof(job_t) * l->capjobs);
+            l->free_jobs = realloc(l->free_jobs, sizeof(int) * l->capjobs);
+            l->live = realloc(l->live, sizeof(int) * l->capjobs);
+            assert(l->jobs != NULL && l->free_jobs != NULL && l->live != NULL);
+        }
+        job = l->njobs++;
+    }
+
+    currency_t *cur = &l->cur[c];
+    job_t *j = &l->jobs[job];
+    j->currency = c;
+    j->tickets = tickets;
+    j->eff = tickets;
+    if (cur->nfree > 0)
+    {
+        j->slot = cur->free_slots[--cur->nfree];
+        fenwick_add(&cur->eff, j->slot, tickets);
+    }
+    else
+    {
+        int oldcap = cur->eff.cap;
+        j->slot = fenwick_push(&cur->eff, tickets);
+        if (cur->eff.cap != oldcap)
+        {
+            cur->slot_job = realloc(cur->slot_job, sizeof(int) * cur->eff.cap);
+            cur->free_slots = realloc(cur->free_slots, sizeof(int) * cur->eff.cap);
+            assert(cur->slot_job != NULL && cur->free_slots != NULL);
+        }
+    }
+    cur->slot_job[j->slot] = job;
+    cur->live++;
+    currency_sync(l, c);
+
+    j->pos = l->nlive;
+    l->live[l->nlive++] = job;
+    return job;
+}
+
+// 任务离开：槽位权重清零并回收，O(log n)
+void job_depart(lottery_t *l, int job)
+{
+    job_t *j = &l->jobs[job];
+    assert(j->pos >= 0);
+    currency_t *cur = &l->cur[j->currency];
+    fenwick_add(&cur->eff, j->slot, -j->eff);
+    cur->free_slots[cur->nfree++] = j->slot;
+    cur->live--;
+    currency_sync(l, j->currency);
+
+    // 从 live[] 中交换删除
+    int last = l->live[--l->nlive];
+    l->live[j->pos] = last;
+    l->jobs[last].pos = j->pos;
+    j->pos = -1;
+    l->free_jobs[l->nfree++] = job;
+}
+
+// 彩票转让：from 把 amount 张彩票交给 to（例如客户端把彩票借给服务器）
+// 两个任务须属于同一货币；跨货币的转让需要换汇，这里不支持，返回 -1
+int job_transfer(lottery_t *l, int from, int to, long amount)
+{
+    job_t *a = &l->jobs[from];
+    job_t *b = &l->jobs[to];
+    if (a->currency != b->currency || amount <= 0 || amount >= a->tickets)
+        return -1;
+    // 补偿倍数按面值比例保留
+    long aeff = a->eff - amount * a->eff / a->tickets;
+    long beff = b->eff + amount * b->eff / b->tickets;
+    a->tickets -= amount;
+    b->tickets += amount;
+    job_set_eff(l, from, aeff > 0 ? aeff : 1);
+    job_set_eff(l, to, beff);
+    return 0;
+}
+
+// 货币通胀/紧缩：调整货币的基础资金，货币内各任务的价值随之按比例变化，O(log C)
+void currency_inflate(lottery_t *l, int c, long funding)
+{
+    assert(funding > 0);
+    l->cur[c].funding = funding;
+    currency_sync(l, c);
+}
+
+// 补偿彩票：任务只用了 used / QUANTUM 的时间片就让出 CPU，
+// 在下次中奖前其彩票放大为 tickets * QUANTUM / used
+void job_compensate(lottery_t *l, int job, int used)
+{
+    assert(used > 0 && used <= QUANTUM);
+    job_t *j = &l->jobs[job];
+    job_set_eff(l, job, j->tickets * QUANTUM / used);
+}
+
+// 抽奖：返回中奖任务编号；中奖任务的补偿彩票随之失效
+int lottery_draw(lottery_t *l, rng_t *r)
+{
+    assert(l->top.total > 0);
+    int c = fenwick_find(&l->top, rng_bounded(r, l->top.total));
+    currency_t *cur = &l->cur[c];
+    int slot = fenwick_find(&cur->eff, rng_bounded(r, cur->eff.total));
+    int job = cur->slot_job[slot];
+    if (l->jobs[job].eff != l->jobs[job].tickets)
+        job_set_eff(l, job, l->jobs[job].tickets);
+    return job;
+}
+
+// 一致性检查：从头重新计算每棵树的总和，与增量维护的结果比对
+void lottery_check(lottery_t *l)
+{
+    int c, i;
+    long top = 0;
+    for (c = 0; c < l->ncur; c++)
+    {
+        currency_t *cur = &l->cur[c];
+        long sum = 0;
+        int live = 0;
+        for (i = 0; i < l->nlive; i++)
+        {
+            job_t *j = &l->jobs[l->live[i]];
+            if (j->currency != c)
+                continue;
+            assert(fenwick_get(&cur->eff, j->slot) == j->eff);
+            sum += j->eff;
+            live++;
+        }
+        assert(sum == cur->eff.total && live == cur->live);
+        assert(fenwick_get(&l->top, c) == (live > 0 ? cur->funding : 0));
+        top += live > 0 ? cur->funding : 0;
+    }
+    assert(top == l->top.total);
+}
+
+#endif // __tickets_h__
@@ -0,0 +1,473 @@
+// 多级反馈队列（MLFQ）调度模拟器
+//
+// 规则（对应教材的最终版本）：
+//   1. 优先级高者先运行；2. 同优先级轮转；3. 新任务进入最高优先级；
+//   4. 任务在某一层用完配额（allotment）就降一级，无论期间是否因 I/O 让出过 CPU；
+//   5. 每隔 boost 个时间单位，把所有任务提升到最高优先级
+//
+// 实现要点：
+//   - 每层一个 FIFO 队列（侵入式单链表），另有一个 64 位位图记录哪些层非空，
+//     选下一个任务只需一次 find-first-set（__builtin_ctzll），O(1)
+//   - 优先级提升：把各层链表依次拼接到第 0 层尾部，O(层数)；
+//     任务的层号与配额通过 "提升纪元" 惰性重置：被选中或从 I/O 返回时才检查
+//   - 等待 I/O 的任务放在按唤醒时间排序的最小堆中
+//   - 输入是流式的 trace 文件，每次只读入下一个即将到达的任务，
+//     完成的任务立即回收到对象池，内存占用只与同时存活的任务数有关
+//
+// trace 格式：每行一个任务，按到达时间非降序
+//   <arrival> <runtime> <io-every> <io-time>
+//   io-every 为 0 表示该任务不做 I/O；否则每运行 io-every 个时间单位就发起一次耗时 io-time 的 I/O
+//
+// To compile: make
+// To run:     ./mlfq -G 1000000 > trace.txt && ./mlfq -f trace.txt
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+
+#include "common.h"
+#include "rng.h"
+
+#define MAX_LEVELS 64
+
+typedef struct job_t
+{
+    long id;
+    long arrival;
+    long remaining;   // 剩余运行时间
+    long io_every;
+    long io_time;
+    long since_io;    // 距上次 I/O 已运行的时间
+    long first_run;   // 首次运行时刻，-1 表示尚未运行
+    long wake;        // I/O 完成时刻
+    long epoch;       // 任务所在层对应的提升纪元
+    int level;
+    long allot_left;  // 当前层剩余配额
+    long slice_left;  // 当前时间片剩余
+    struct job_t *next;
+} job_t;
+
+// ---------------- 参数 ----------------
+
+int nlevels = 3;
+long quantum = 10;
+int qmult = 1;        // 第 i 层的时间片 = quantum * qmult^i
+long allotment = 1;   // 每层配额，以该层时间片为单位
+long boost = 0;       // 提升周期；0 表示不提升
+
+long qlen[MAX_LEVELS];  // 每层时间片长度
+long allot[MAX_LEVELS]; // 每层配额（时间单位）
+
+// ---------------- 队列与位图 ----------------
+
+job_t *qhead[MAX_LEVELS];
+job_t *qtail[MAX_LEVELS];
+unsigned long long bitmap = 0; // 第 i 位为 1 表示第 i 层非空
+long epoch = 0;                // 每次提升加一
+
+void q_push_back(int level, job_t *j)
+{
+    j->next = NULL;
+    if (qtail[level])
+        qtail[level]->next = j;
+    else
+        qhead[level] = j;
+    qtail[level] = j;
+    bitmap |= 1ULL << level;
+}
+
+// 被抢占的任务回到队头，下次继续用完它剩余的时间片
+void q_push_front(int level, job_t *j)
+{
+    j->next = qhead[level];
+    qhead[level] = j;
+    if (qtail[level] == NULL)
+        qtail[level] = j;
+    bitmap |= 1ULL << level;
+}
+
+job_t *q_pop(int level)
+{
+    job_t *j = qhead[level];
+    qhead[level] = j->next;
+    if (qhead[level] == NULL)
+    {
+        qtail[level] = NULL;
+        bitmap &= ~(1ULL << level);
+    }
+    return j;
+}
+
+// O(1) 选出最高优先级的非空层；没有就绪任务时返回 -1
+int q_top()
+{
+    return bitmap ? __builtin_ctzll(bitmap) : -1;
+}
+
+void set_level(job_t *j, int level)
+{
+    j->level = level;
+    j->allot_left = allot[level];
+    j->slice_left = qlen[level];
+    j->epoch = epoch;
+}
+
+// 规则 5：所有层拼接到第 0 层，并重置配额
+void do_boost()
+{
+    int l;
+    epoch++;
+    for (l = 1; l < nlevels; l++)
+    {
+        if (qhead[l] == NULL)
+            continue;
+        if (qtail[0])
+            qtail[0]->next = qhead[l];
+        else
+            qhead[0] = qhead[l];
+        qtail[0] = qtail[l];
+        qhead[l] = qtail[l] = NULL;
+    }
+    bitmap = qhead[0] ? 1 : 0;
+    // 配额的重置推迟到任务下次被选中时（纪元不符即说明错过了提升）
+}
+
+// ---------------- I/O 等待堆 ----------------
+
+job_t **ioheap;
+int ionum = 0, iocap = 0;
+
+void io_push(job_t *j)
+{
+    if (ionum == iocap)
+    {
+        iocap = iocap ? iocap * 2 : 1024;
+        ioheap = realloc(ioheap, sizeof(job_t *) * iocap);
+        assert(ioheap != NULL);
+    }
+    int i = ionum++;
+    while (i > 0 && ioheap[(i - 1) / 2]->wake > j->wake)
+    {
+        ioheap[i] = ioheap[(i - 1) / 2];
+        i = (i - 1) / 2;
+    }
+    ioheap[i] = j;
+}
+
+job_t *io_pop()
+{
+    job_t *top = ioheap[0];
+    job_t *last = ioheap[--ionum];
+    int i = 0;
+    for (;;)
+    {
+        int c = 2 * i + 1;
+        if (c >= ionum)
+            break;
+        if (c + 1 < ionum && ioheap[c + 1]->wake < ioheap[c]->wake)
+            c++;
+        if (ioheap[c]->wake >= last->wake)
+            break;
+        ioheap[i] = ioheap[c];
+        i = c;
+    }
+    if (ionum > 0)
+        ioheap[i] = last;
+    return top;
+}
+
+// ---------------- 任务对象池 ----------------
+
+job_t *pool_free = NULL;
+
+job_t *job_alloc()
+{
+    if (pool_free == NULL)
+    {
+        // 一次分配一批，串成空闲链表
+        int n = 4096, i;
+        job_t *batch = malloc(sizeof(job_t) * n);
+        assert(batch != NULL);
+        for (i = 0; i < n; i++)
+        {
+            batch[i].next = pool_free;
+            pool_free = &batch[i];
+        }
+    }
+    job_t *j = pool_free;
+    pool_free = j->next;
+    return j;
+}
+
+void job_release(job_t *j)
+{
+    j->next = pool_free;
+    pool_free = j;
+}
+
+// ---------------- 对数分桶直方图 ----------------
+// 值 v 落在 [2^e, 2^(e+1)) 时再线性细分为 HIST_SUB 个子桶，相对误差约 1/HIST_SUB
+
+#define HIST_SUB 32
+#define HIST_EXP 48
+
+typedef struct
+{
+    long counts[HIST_EXP][HIST_SUB];
+    long n;
+    double sum;
+    long max;
+} hist_t;
+
+void hist_add(hist_t *h, long v)
+{
+    if (v < 0)
+        v = 0;
+    int e = v > 0 ? 63 - __builtin_clzll(v) : 0;
+    int sub = e >= 5 ? (int)((v >> (e - 5)) & (HIST_SUB - 1)) : (int)(v & (HIST_SUB - 1));
+    h->counts[e][sub]++;
+    h->n++;
+    h->sum += v;
+    if (v > h->max)
+        h->max = v;
+}
+
+// 桶的代表值（桶下界）
+long hist_value(int e, int sub)
+{
+    if (e < 5)
+        return sub;
+    return (1L << e) | ((long)sub << (e - 5));
+}
+
+long hist_percentile(hist_t *h, double p)
+{
+    long want = (long)ceil(p / 100.0 * h->n);
+    long seen = 0;
+    int e, s;
+    for (e = 0; e < HIST_EXP; e++)
+        for (s = 0; s < HIST_SUB; s++)
+        {
+            seen += h->counts[e][s];
+            if (seen >= want && h->counts[e][s] > 0)
+                return hist_value(e, s);
+        }
+    return h->max;
+}
+
+void hist_print(const char *name, hist_t *h)
+{
+    printf("%-11s %12.1f %10ld %10ld %10ld %10ld %10ld\n", name, h->n ? h->sum / h->n : 0.0,
+           hist_percentile(h, 50), hist_percentile(h, 90), hist_percentile(h, 99),
+           hist_percentile(h, 99.9), h->max);
+}
+
+hist_t response, turnaround;
+
+// ---------------- trace ----------------
+
+FILE *trace;
+job_t *pending = NULL; // 已读入、尚未到达的下一个任务
+long nextid = 0;
+
+void read_next()
+{
+    long arrival, runtime, io_every, io_time;
+    pending = NULL;
+    if (fscanf(trace, "%ld %ld %ld %ld", &arrival, &runtime, &io_every, &io_time) != 4)
+        return;
+    assert(runtime > 0 && io_every >= 0 && io_time >= 0);
+    job_t *j = job_alloc();
+    j->id = nextid++;
+    j->arrival = arrival;
+    j->remaining = runtime;
+    j->io_every = io_every;
+    j->io_time = io_time;
+    j->since_io = 0;
+    j->first_run = -1;
+    pending = j;
+}
+
+// 生成 trace：泊松到达，指数分布运行时间，frac 比例的任务是交互式（频繁 I/O）
+void generate(long n, uint64_t seed, double gap, double mean, double frac)
+{
+    rng_t r;
+    rng_seed(&r, seed);
+    double t = 0;
+    long i;
+    for (i = 0; i < n; i++)
+    {
+        t += -gap * log(1.0 - rng_double(&r));
+        long runtime = 1 + (long)(-mean * log(1.0 - rng_double(&r)));
+        if (rng_double(&r) < frac)
+            printf("%ld %ld %ld %ld\n", (long)t, runtime, 1 + (long)rng_bounded(&r, quantum), 5 * quantum);
+        else
+            printf("%ld %ld 0 0\n", (long)t, runtime);
+    }
+}
+
+void usage()
+{
+    fprintf(stderr, "usage: mlfq -f <trace> [-n levels] [-q quantum] [-m quantum-mult] [-a allotment] [-b boost]\n"
+                    "       mlfq -G <jobs> [-s seed] [-g mean-gap] [-r mean-runtime] [-i interactive-frac] [-q quantum]\n");
+    exit(1);
+}
+
+int main(int argc, char *argv[])
+{
+    char *tracefile = NULL;
+    long gen = 0;
+    uint64_t seed = 1;
+    double gap = 20, mean_runtime = 15, frac = 0.3;
+    int opt;
+    while ((opt = getopt(argc, argv, "f:n:q:m:a:b:G:s:g:r:i:")) != -1)
+    {
+        switch (opt)
+        {
+        case 'f': tracefile = optarg; break;
+        case 'n': nlevels = atoi(optarg); break;
+        case 'q': quantum = atol(optarg); break;
+        case 'm': qmult = atoi(optarg); break;
+        case 'a': allotment = atol(optarg); break;
+        case 'b': boost = atol(optarg); break;
+        case 'G': gen = atol(optarg); break;
+        case 's': seed = atol(optarg); break;
+        case 'g': gap = atof(optarg); break;
+        case 'r': mean_runtime = atof(optarg); break;
+        case 'i': frac = atof(optarg); break;
+        default: usage();
+        }
+    }
+    assert(nlevels > 0 && nlevels <= MAX_LEVELS && quantum > 0 && qmult > 0 && allotment > 0 && boost >= 0);
+    if (gen > 0)
+    {
+        generate(gen, seed, gap, mean_runtime, frac);
+        return 0;
+    }
+    if (tracefile == NULL)
+        usage();
+    trace = strcmp(tracefile, "-") == 0 ? stdin : fopen(tracefile, "r");
+    if (trace == NULL)
+    {
+        fprintf(stderr, "cannot open %s\n", tracefile);
+        exit(1);
+    }
+
+    int l;
+    for (l = 0; l < nlevels; l++)
+    {
+        qlen[l] = (l == 0) ? quantum : qlen[l - 1] * qmult;
+        allot[l] = qlen[l] * allotment;
+    }
+
+    long now = 0, busy = 0, done = 0, live = 0, maxlive = 0;
+    long next_boost = boost ? boost : -1;
+    double start = GetTime();
+    read_next();
+    for (;;)
+    {
+        // 1. 处理到达、I/O 完成与优先级提升（按发生时刻）
+        while (pending && pending->arrival <= now)
+        {
+            set_level(pending, 0);
+            q_push_back(0, pending);
+            live++;
+            read_next();
+        }
+        while (ionum > 0 && ioheap[0]->wake <= now)
+        {
+            job_t *j = io_pop();
+            // 等待期间发生过提升：回到最高层
+            if (j->epoch != epoch)
+                set_level(j, 0);
+            q_push_back(j->level, j);
+        }
+        if (next_boost >= 0 && now >= next_boost)
+        {
+            do_boost();
+            next_boost += boost;
+        }
+        if (live > maxlive)
+            maxlive = live;
+
+        int top = q_top();
+        if (top < 0)
+        {
+            // 2. 空闲：直接跳到下一个事件
+            long next = -1;
+            if (pending)
+                next = pending->arrival;
+            if (ionum > 0 && (next < 0 || ioheap[0]->wake < next))
+                next = ioheap[0]->wake;
+            if (next < 0)
+                break; // 所有任务都已完成
+            now = next;
+            continue;
+        }
+
+        // 3. 运行：直到时间片用完、任务完成、发起 I/O，或下一个可能抢占的事件
+        job_t *j = q_pop(top);
+        if (j->epoch != epoch)
+            set_level(j, 0);
+        if (j->first_run < 0)
+        {
+            j->first_run = now;
+            hist_add(&response, now - j->arrival);
+        }
+        long run = j->slice_left;
+        if (j->remaining < run)
+            run = j->remaining;
+        if (j->io_every > 0 && j->io_every - j->since_io < run)
+            run = j->io_every - j->since_io;
+        if (pending && pending->arrival > now && pending->arrival - now < run)
+            run = pending->arrival - now;
+        if (ionum > 0 && ioheap[0]->wake > now && ioheap[0]->wake - now < run)
+            run = ioheap[0]->wake - now;
+        if (next_boost > now && next_boost - now < run)
+            run = next_boost - now;
+
+        now += run;
+        busy += run;
+        j->remaining -= run;
+        j->slice_left -= run;
+        j->allot_left -= run;
+        j->since_io += run;
+
+        if (j->remaining == 0)
+        {
+            hist_add(&turnaround, now - j->arrival);
+            done++;
+            live--;
+            job_release(j);
+            continue;
+        }
+        // 规则 4：配额用完则降级（最低层保持不动，但重新获得配额）
+        if (j->allot_left <= 0)
+            set_level(j, j->level + 1 < nlevels ? j->level + 1 : j->level);
+        else if (j->slice_left == 0)
+            j->slice_left = qlen[j->level];
+
+        if (j->io_every > 0 && j->since_io == j->io_every)
+        {
+            j->since_io = 0;
+            j->wake = now + j->io_time;
+            io_push(j);
+        }
+        else if (j->slice_left < qlen[j->level])
+            q_push_front(j->level, j); // 被事件打断：回到队头继续用完时间片
+        else
+            q_push_back(j->level, j);
+    }
+    double elapsed = GetTime() - start;
+
+    printf("levels: %d  quantum: %ld (x%d per level)  allotment: %ld quanta  boost: %ld\n",
+           nlevels, quantum, qmult, allotment, boost);
+    printf("jobs: %ld  max live: %ld  time: %ld  utilization: %.2f%%  (%.0f jobs/sec simulated)\n",
+           done, maxlive, now, now ? 100.0 * busy / now : 0.0, done / elapsed);
+    printf("%-11s %12s %10s %10s %10s %10s %10s\n", "", "mean", "p50", "p90", "p99", "p99.9", "max");
+    hist_print("response", &response);
+    hist_print("turnaround", &turnaround);
+    return 0;
+}
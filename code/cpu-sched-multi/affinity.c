@@ -0,0 +1,228 @@
+// 缓存亲和性与迁移代价的实测（对应 cache-timeline 图背后的数据）
+// 每个线程反复遍历自己的工作集：工作集中每个缓存行恰好访问一次，按随机顺序链成一个环，
+// 每次访问都读写该行（缓存行变脏，迁移后新 CPU 必须从别处取回）。遍历一圈称为一轮（pass）。
+//
+// 三种模式：
+//   pinned - 每个线程绑定在一个 CPU 上，禁止迁移
+//   float  - 不绑定，由内核负载均衡决定线程在哪里运行
+//   forced - 每隔 K 轮把线程强制迁移到一个不共享 LLC（其次不共享物理核）的 CPU
+// 迁移之后的第一轮称为冷轮，其余为热轮；冷轮比热轮多出的时间就是缓存重新预热的代价。
+// 最后报告每种模式相对 pinned 的吞吐损失。
+// To compile: make affinity
+// To run:     ./affinity 4 1024 2 10
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "common_threads.h"
+#include "topology.h"
+#include "rng.h"
+
+#define LINE 64
+
+typedef enum
+{
+    MODE_PINNED,
+    MODE_FLOAT,
+    MODE_FORCED
+} affinity_mode_t;
+
+const char *mode_names[] = {"pinned", "float", "forced"};
+
+typedef struct
+{
+    long next;        // 环上下一个缓存行的下标
+    long counter;
+    char pad[LINE - 2 * sizeof(long)];
+} line_t;
+
+// 每个线程的参数与结果；按缓存行对齐，避免线程之间的伪共享
+typedef struct
+{
+    int id;
+    int cpu;          // 初始 CPU（pinned/forced）
+    affinity_mode_t mode;
+    long passes;
+    long warm_passes;
+    long cold_passes;
+    long warm_ns;
+    long cold_ns;
+    long migrations;  // 实际观察到的 CPU 变化次数
+} __attribute__((aligned(64))) worker_t;
+
+topology_t topo;
+long ws_lines;
+long run_ns;
+int migrate_every;
+
+long now_ns()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000L + ts.tv_nsec;
+}
+
+// 工作集中的缓存行按随机排列链成一个环，硬件预取器猜不到下一个地址
+line_t *make_ring(uint64_t seed)
+{
+    line_t *ws;
+    assert(posix_memalign((void **)&ws, 4096, ws_lines * sizeof(line_t)) == 0);
+    uint32_t *next = malloc(sizeof(uint32_t) * ws_lines);
+    assert(next != NULL);
+    rng_t rng;
+    rng_seed(&rng, seed);
+    rng_cycle(&rng, next, ws_lines);
+    long i;
+    for (i = 0; i < ws_lines; i++)
+    {
+        ws[i].next = next[i];
+        ws[i].counter = 0;
+    }
+    free(next);
+    return ws;
+}
+
+long one_pass(line_t *ws)
+{
+    long i, cur = 0;
+    for (i = 0; i < ws_lines; i++)
+    {
+        ws[cur].counter++;
+        cur = ws[cur].next;
+    }
+    return cur;
+}
+
+void *worker(void *arg)
+{
+    worker_t *w = (worker_t *)arg;
+    line_t *ws = make_ring(w->id + 1); // 在运行的 CPU 上分配并初始化，首次触碰即在本地
+    one_pass(ws);                      // 预热
+    int cpu = sched_getcpu();
+    int hops = 0;
+    long end = now_ns() + run_ns;
+    long t = now_ns();
+    int cold = 0;
+    while (t < end)
+    {
+        if (w->mode == MODE_FORCED && w->passes > 0 && w->passes % migrate_every == 0)
+        {
+            Pin_to_cpu(topology_far_cpu(&topo, cpu, hops++ + w->id));
+            t = now_ns(); // 迁移本身（系统调用 + 上下文切换）不计入冷轮
+        }
+        int now_cpu = sched_getcpu();
+        if (now_cpu != cpu)
+        {
+            w->migrations++;
+            cpu = now_cpu;
+            cold = 1;
+        }
+        one_pass(ws);
+        long t2 = now_ns();
+        // 一轮之中也可能发生迁移（float 模式），结束时再检查一次
+        if (sched_getcpu() != cpu)
+            cold = 1;
+        if (cold)
+        {
+            w->cold_passes++;
+            w->cold_ns += t2 - t;
+        }
+        else
+        {
+            w->warm_passes++;
+            w->warm_ns += t2 - t;
+        }
+        cold = 0;
+        w->passes++;
+        t = t2;
+    }
+    free(ws);
+    return NULL;
+}
+
+// 运行一种模式，返回每秒完成的总轮数
+double run_mode(affinity_mode_t mode, int nthreads)
+{
+    pthread_t *threads = malloc(sizeof(pthread_t) * nthreads);
+    worker_t *workers;
+    assert(threads != NULL);
+    assert(posix_memalign((void **)&workers, 64, sizeof(worker_t) * nthreads) == 0);
+    memset(workers, 0, sizeof(worker_t) * nthreads);
+    int i;
+    long start = now_ns();
+    for (i = 0; i < nthreads; i++)
+    {
+        workers[i].id = i;
+        workers[i].mode = mode;
+        workers[i].cpu = topo.cpus[i % topo.ncpus].cpu;
+        if (mode == MODE_FLOAT)
+        {
+            Pthread_create(&threads[i], NULL, worker, &workers[i]);
+        }
+        else
+        {
+            Pthread_create_on_cpu(&threads[i], workers[i].cpu, worker, &workers[i]);
+        }
+    }
+    for (i = 0; i < nthreads; i++)
+        Pthread_join(threads[i], NULL);
+    double elapsed = (now_ns() - start) / 1e9;
+
+    long passes = 0, warm = 0, cold = 0, warm_ns = 0, cold_ns = 0, migrations = 0;
+    for (i = 0; i < nthreads; i++)
+    {
+        passes += workers[i].passes;
+        warm += workers[i].warm_passes;
+        cold += workers[i].cold_passes;
+        warm_ns += workers[i].warm_ns;
+        cold_ns += workers[i].cold_ns;
+        migrations += workers[i].migrations;
+    }
+    double warm_pass = warm ? (double)warm_ns / warm : 0;
+    double cold_pass = cold ? (double)cold_ns / cold : 0;
+    printf("%-7s %12.1f %12.1f %10.2f %12.1f %10.2f %11ld\n", mode_names[mode],
+           passes / elapsed, warm_pass / 1000, warm_pass / ws_lines,
+           cold_pass / 1000, cold ? cold_pass / ws_lines : 0, migrations);
+    free(threads);
+    free(workers);
+    return passes / elapsed;
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc != 5)
+    {
+        fprintf(stderr, "usage: affinity <threads> <working-set-KB> <seconds-per-mode> <migrate-every-passes>\n");
+        exit(1);
+    }
+    int nthreads = atoi(argv[1]);
+    long ws_kb = atol(argv[2]);
+    double seconds = atof(argv[3]);
+    migrate_every = atoi(argv[4]);
+    assert(nthreads > 0 && ws_kb > 0 && seconds > 0 && migrate_every > 0);
+    ws_lines = ws_kb * 1024 / LINE;
+    assert(ws_lines > 1);
+    run_ns = (long)(seconds * 1e9);
+
+    topology_discover(&topo);
+    topology_print(&topo);
+    printf("\nthreads: %d  working set: %ld KB (%ld lines)  migrate every %d passes\n\n",
+           nthreads, ws_kb, ws_lines, migrate_every);
+    if (topo.ncpus == 1)
+        printf("note: only one CPU online, forced migrations stay on the same CPU\n\n");
+
+    printf("%-7s %12s %12s %10s %12s %10s %11s\n", "mode", "passes/s", "warm-us", "warm-ns/ln",
+           "cold-us", "cold-ns/ln", "migrations");
+    double rate[3];
+    affinity_mode_t m;
+    for (m = MODE_PINNED; m <= MODE_FORCED; m++)
+        rate[m] = run_mode(m, nthreads);
+
+    printf("\nthroughput loss vs pinned:\n");
+    for (m = MODE_FLOAT; m <= MODE_FORCED; m++)
+        printf("  %-7s %6.2f%%\n", mode_names[m], 100.0 * (rate[MODE_PINNED] - rate[m]) / rate[MODE_PINNED]);
+    return 0;
+}
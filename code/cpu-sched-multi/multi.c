@@ -0,0 +1,361 @@
+// 多处理器调度模拟器：单队列（SQMS）与多队列（MQMS）+ 负载均衡 + 缓存亲和性
+// 对应 Pics-cpu-sched-multi 中的 multi-sched-queue 与 cache-timeline 图
+//
+// 时间以时间片为单位推进，每个时间片每个 CPU 运行其队列头部的任务一次（轮转）。
+// 缓存亲和性模型：
+//   每个 CPU 的缓存最多同时容纳 cache_slots 个任务的工作集；
+//   任务在上次运行的 CPU 上再次运行、且这期间该 CPU 运行过的其他任务不超过 cache_slots 个时，
+//   缓存是热的，完整推进一个时间片；否则需要先花 warmup 个时间单位预热缓存。
+//
+// 策略：
+//   sqms     - 所有 CPU 共享一个全局队列（天然均衡，但任务在 CPU 之间来回跳，亲和性差）
+//   mqms     - 每个 CPU 一个队列，新任务随机放入某个队列，不做均衡
+//   steal    - mqms + 工作窃取：队列空的 CPU 随机挑选受害者，偷走其一半任务
+//   migrate  - mqms + 周期性迁移：每隔 interval 个时间片把最长队列的任务迁往最短队列
+// To compile: make
+// To run:     ./multi -c 64 -n 1000000 -p steal
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+
+#include "common.h"
+#include "rng.h"
+
+typedef struct
+{
+    int remaining;  // 剩余工作量（时间单位）
+    int last_cpu;   // 上次运行的 CPU，-1 表示从未运行
+    long cache_gen; // 上次运行时该 CPU 的运行计数
+} job_t;
+
+// 环形双端队列，保存任务编号
+typedef struct
+{
+    int *buf;
+    int cap; // 2 的幂
+    int head;
+    int len;
+} deque_t;
+
+typedef enum
+{
+    POLICY_SQMS,
+    POLICY_MQMS,
+    POLICY_STEAL,
+    POLICY_MIGRATE
+} policy_t;
+
+const char *policy_names[] = {"sqms", "mqms", "steal", "migrate"};
+
+void dq_init(deque_t *q)
+{
+    q->cap = 16;
+    q->buf = malloc(sizeof(int) * q->cap);
+    assert(q->buf != NULL);
+    q->head = 0;
+    q->len = 0;
+}
+
+void dq_grow(deque_t *q)
+{
+    int *nb = malloc(sizeof(int) * q->cap * 2);
+    assert(nb != NULL);
+    int i;
+    for (i = 0; i < q->len; i++)
+        nb[i] = q->buf[(q->head + i) & (q->cap - 1)];
+    free(q->buf);
+    q->buf = nb;
+    q->cap *= 2;
+    q->head = 0;
+}
+
+void dq_push_back(deque_t *q, int job)
+{
+    if (q->len == q->cap)
+        dq_grow(q);
+    q->buf[(q->head + q->len) & (q->cap - 1)] = job;
+    q->len++;
+}
+
+int dq_pop_front(deque_t *q)
+{
+    assert(q->len > 0);
+    int job = q->buf[q->head];
+    q->head = (q->head + 1) & (q->cap - 1);
+    q->len--;
+    return job;
+}
+
+int dq_pop_back(deque_t *q)
+{
+    assert(q->len > 0);
+    q->len--;
+    return q->buf[(q->head + q->len) & (q->cap - 1)];
+}
+
+// ---------------- 模拟参数与状态 ----------------
+
+int ncpus = 4;
+long njobs = 100000;
+policy_t policy = POLICY_STEAL;
+int quantum = 10;      // 时间片长度（时间单位）
+int warmup = 3;        // 冷缓存的预热代价（时间单位）
+int cache_slots = 4;   // 每个 CPU 缓存可容纳的工作集个数
+int mean_runtime = 100; // 任务平均工作量（时间单位，指数分布）
+double arrival_rate = 0; // 每个时间片到达的任务数；0 表示全部在时刻 0 到达
+int interval = 10;     // migrate 策略的均衡周期（时间片）
+long sample = 0;       // 每隔多少时间片输出一次不均衡度；0 表示自动选择
+uint64_t seed = 1;
+
+job_t *jobs;
+deque_t *queues; // sqms 只使用 queues[0]
+long *cpu_gen;   // 每个 CPU 的运行计数
+int *running;    // 本时间片各 CPU 上运行的任务（-1 表示空闲）
+rng_t rng;
+
+long migrations = 0;  // 任务在与上次不同的 CPU 上运行
+long queue_moves = 0; // 窃取或均衡把任务移到另一个队列
+long cold_runs = 0;
+long busy_slots = 0; // CPU 忙碌的时间片数
+
+int queue_of_cpu(int cpu)
+{
+    return policy == POLICY_SQMS ? 0 : cpu;
+}
+
+// 在 cpu 上运行 job 一个时间片，返回是否完成
+int run_job(int cpu, int job)
+{
+    job_t *j = &jobs[job];
+    int progress = quantum;
+    int warm = (j->last_cpu == cpu) && (cpu_gen[cpu] - j->cache_gen <= cache_slots);
+    if (!warm)
+    {
+        progress -= warmup;
+        cold_runs++;
+    }
+    j->remaining -= progress;
+    if (j->last_cpu != -1 && j->last_cpu != cpu)
+        migrations++;
+    j->last_cpu = cpu;
+    j->cache_gen = ++cpu_gen[cpu];
+    return j->remaining <= 0;
+}
+
+// 工作窃取：随机选两个受害者，取较长者，从其尾部偷走一半任务
+void steal(int thief)
+{
+    int v1 = rng_bounded(&rng, ncpus);
+    int v2 = rng_bounded(&rng, ncpus);
+    int victim = queues[v1].len >= queues[v2].len ? v1 : v2;
+    if (victim == thief || queues[victim].len < 2)
+        return;
+    int k = queues[victim].len / 2;
+    while (k-- > 0)
+    {
+        dq_push_back(&queues[thief], dq_pop_back(&queues[victim]));
+        queue_moves++;
+    }
+}
+
+// 周期性迁移：反复把最长队列尾部的任务移到最短队列，直到长度差不超过 1
+void migrate()
+{
+    for (;;)
+    {
+        int i, maxq = 0, minq = 0;
+        for (i = 1; i < ncpus; i++)
+        {
+            if (queues[i].len > queues[maxq].len)
+                maxq = i;
+            if (queues[i].len < queues[minq].len)
+                minq = i;
+        }
+        int diff = queues[maxq].len - queues[minq].len;
+        if (diff <= 1)
+            return;
+        int k = diff / 2;
+        while (k-- > 0)
+        {
+            dq_push_back(&queues[minq], dq_pop_back(&queues[maxq]));
+            queue_moves++;
+        }
+    }
+}
+
+// 各 CPU 队列长度的不均衡度；在第 4 步把任务放回队列之后调用，此时没有任务在运行
+void imbalance(long *maxlen, long *minlen, double *cv)
+{
+    int i;
+    double sum = 0, sumsq = 0;
+    *maxlen = *minlen = queues[0].len;
+    for (i = 0; i < ncpus; i++)
+    {
+        long len = queues[i].len;
+        if (len > *maxlen)
+            *maxlen = len;
+        if (len < *minlen)
+            *minlen = len;
+        sum += len;
+        sumsq += (double)len * len;
+    }
+    double mean = sum / ncpus;
+    double var = sumsq / ncpus - mean * mean;
+    *cv = mean > 0 ? sqrt(var > 0 ? var : 0) / mean : 0;
+}
+
+void usage()
+{
+    fprintf(stderr, "usage: multi [-c cpus] [-n jobs] [-p sqms|mqms|steal|migrate] [-q quantum]\n"
+                    "             [-w warmup] [-k cache-slots] [-r mean-runtime] [-a arrivals-per-tick]\n"
+                    "             [-i migrate-interval] [-t sample-interval] [-s seed]\n");
+    exit(1);
+}
+
+int main(int argc, char *argv[])
+{
+    int opt;
+    while ((opt = getopt(argc, argv, "c:n:p:q:w:k:r:a:i:t:s:")) != -1)
+    {
+        switch (opt)
+        {
+        case 'c': ncpus = atoi(optarg); break;
+        case 'n': njobs = atol(optarg); break;
+        case 'q': quantum = atoi(optarg); break;
+        case 'w': warmup = atoi(optarg); break;
+        case 'k': cache_slots = atoi(optarg); break;
+        case 'r': mean_runtime = atoi(optarg); break;
+        case 'a': arrival_rate = atof(optarg); break;
+        case 'i': interval = atoi(optarg); break;
+        case 't': sample = atol(optarg); break;
+        case 's': seed = atol(optarg); break;
+        case 'p':
+            for (policy = POLICY_SQMS; policy <= POLICY_MIGRATE; policy++)
+                if (strcmp(optarg, policy_names[policy]) == 0)
+                    break;
+            if (policy > POLICY_MIGRATE)
+                usage();
+            break;
+        default:
+            usage();
+        }
+    }
+    assert(ncpus > 0 && njobs > 0 && quantum > warmup && warmup >= 0);
+    assert(mean_runtime > 0 && interval > 0 && arrival_rate >= 0);
+
+    rng_seed(&rng, seed);
+    jobs = malloc(sizeof(job_t) * njobs);
+    queues = malloc(sizeof(deque_t) * ncpus);
+    cpu_gen = calloc(ncpus, sizeof(long));
+    running = malloc(sizeof(int) * ncpus);
+    assert(jobs != NULL && queues != NULL && cpu_gen != NULL && running != NULL);
+    int i;
+    for (i = 0; i < ncpus; i++)
+    {
+        dq_init(&queues[i]);
+        running[i] = -1;
+    }
+
+    // 工作量服从指数分布：少数长任务、大量短任务，是造成队列不均衡的主要来源
+    long total_work = 0;
+    long j;
+    for (j = 0; j < njobs; j++)
+    {
+        jobs[j].remaining = 1 + (int)(-mean_runtime * log(1.0 - rng_double(&rng)));
+        jobs[j].last_cpu = -1;
+        jobs[j].cache_gen = 0;
+        total_work += jobs[j].remaining;
+    }
+    if (sample == 0)
+        sample = 1 + total_work / quantum / ncpus / 20;
+
+    long arrived = 0;
+    double arrival_credit = 0;
+    long done = 0;
+    long now = 0;
+    printf("%10s %10s %10s %11s %8s %8s %8s\n", "tick", "done", "migrations", "queue-moves", "maxq", "minq", "cv");
+    double start = GetTime();
+    while (done < njobs)
+    {
+        // 1. 新任务到达：sqms 进全局队列，其余策略随机选一个 CPU 队列
+        long newjobs;
+        if (arrival_rate == 0)
+            newjobs = njobs - arrived;
+        else
+        {
+            arrival_credit += arrival_rate;
+            newjobs = (long)arrival_credit;
+            arrival_credit -= newjobs;
+            if (newjobs > njobs - arrived)
+                newjobs = njobs - arrived;
+        }
+        while (newjobs-- > 0)
+        {
+            int q = policy == POLICY_SQMS ? 0 : (int)rng_bounded(&rng, ncpus);
+            dq_push_back(&queues[q], arrived++);
+        }
+
+        // 2. 负载均衡
+        if (policy == POLICY_MIGRATE && now % interval == 0)
+            migrate();
+
+        // 3. 每个 CPU 从自己的队列取任务（队列空时按策略窃取）
+        for (i = 0; i < ncpus; i++)
+        {
+            deque_t *q = &queues[queue_of_cpu(i)];
+            if (q->len == 0 && policy == POLICY_STEAL)
+                steal(i);
+            running[i] = q->len > 0 ? dq_pop_front(q) : -1;
+        }
+
+        // 4. 运行一个时间片；没做完的任务回到所在队列的尾部
+        for (i = 0; i < ncpus; i++)
+        {
+            if (running[i] < 0)
+                continue;
+            busy_slots++;
+            if (run_job(i, running[i]))
+                done++;
+            else
+                dq_push_back(&queues[queue_of_cpu(i)], running[i]);
+            running[i] = -1;
+        }
+
+        if (now % sample == 0)
+        {
+            printf("%10ld %10ld %10ld %11ld", now, done, migrations, queue_moves);
+            if (policy == POLICY_SQMS) // 只有一个全局队列，谈不上不均衡
+                printf(" %8s %8s %8s\n", "n/a", "n/a", "n/a");
+            else
+            {
+                long maxlen, minlen;
+                double cv;
+                imbalance(&maxlen, &minlen, &cv);
+                printf(" %8ld %8ld %8.3f\n", maxlen, minlen, cv);
+            }
+        }
+        now++;
+    }
+    double elapsed = GetTime() - start;
+
+    printf("\npolicy: %s  cpus: %d  jobs: %ld  quantum: %d  warmup: %d  cache-slots: %d\n",
+           policy_names[policy], ncpus, njobs, quantum, warmup, cache_slots);
+    printf("makespan:     %ld ticks\n", now);
+    printf("throughput:   %.3f jobs/tick\n", (double)njobs / now);
+    printf("utilization:  %.2f%%\n", 100.0 * busy_slots / ((double)now * ncpus));
+    printf("cold runs:    %.2f%% of %ld runs\n", 100.0 * cold_runs / busy_slots, busy_slots);
+    printf("migrations:   %ld (runs on a different CPU than the previous run)\n", migrations);
+    printf("queue moves:  %ld (jobs moved to another queue by steal or migrate)\n", queue_moves);
+    printf("sim speed:    %.0f job-quanta/sec\n", busy_slots / elapsed);
+
+    for (i = 0; i < ncpus; i++)
+        free(queues[i].buf);
+    free(queues);
+    free(jobs);
+    free(cpu_gen);
+    free(running);
+    return 0;
+}
@@ -58,4 +58,36 @@
 #define Sem_post(sem)                                    assert(sem_post(sem) == 0);
 #endif // __linux__
 
+// Linux下的CPU亲和性封装（需要在包含任何头文件之前定义 _GNU_SOURCE 才能使用 cpu_set_t）
+#if defined(__linux__) && defined(_GNU_SOURCE)
+// 创建线程并把它绑定到指定CPU：线程从第一条指令起就运行在该CPU上
+void Pthread_create_on_cpu(pthread_t *thread, int cpu, void *(*start_routine)(void *), void *arg)
+{
+    pthread_attr_t attr;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    assert(pthread_attr_init(&attr) == 0);
+    assert(pthread_attr_setaffinity_np(&attr, sizeof(cpu_set_t), &set) == 0);
+    assert(pthread_create(thread, &attr, start_routine, arg) == 0);
+    assert(pthread_attr_destroy(&attr) == 0);
+}
+
+// 把调用线程绑定到指定CPU；cpu < 0 表示解除绑定（允许在所有在线CPU上运行）
+void Pin_to_cpu(int cpu)
+{
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (cpu >= 0)
+        CPU_SET(cpu, &set);
+    else
+    {
+        int i;
+        for (i = 0; i < CPU_SETSIZE; i++)
+            CPU_SET(i, &set);
+    }
+    assert(pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &set) == 0);
+}
+#endif // __linux__ && _GNU_SOURCE
+
 #endif // __common_threads_h__
\ No newline at end of file
@@ -0,0 +1,114 @@
+#ifndef __cycles_h__
+#define __cycles_h__
+
+// 周期计数器：比 gettimeofday/clock_gettime 便宜得多，适合测量几十纳秒级别的事件
+//   x86-64:  rdtsc（constant_tsc 的机器上频率恒定，与核心实际频率无关）
+//   aarch64: cntvct_el0（通用定时器的虚拟计数）
+//   其他:    退化为 clock_gettime(CLOCK_MONOTONIC_RAW)，单位即纳秒
+// 计数器的频率通过与 CLOCK_MONOTONIC_RAW（不受 NTP 调频影响）比对来校准，之后用 cycles_to_ns 换算；
+// 没有调用过 cycles_calibrate 时，cycles_to_ns 第一次被调用时会先校准 5ms
+//
+// 另外提供按百分位数汇报一组样本的辅助函数
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <time.h>
+#include <assert.h>
+
+#ifndef CLOCK_MONOTONIC_RAW
+#define CLOCK_MONOTONIC_RAW CLOCK_MONOTONIC
+#endif
+
+static inline uint64_t cycles_now()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    uint32_t lo, hi;
+    __asm__ __volatile__("lfence\n\trdtsc" : "=a"(lo), "=d"(hi) : : "memory");
+    return ((uint64_t)hi << 32) | lo;
+#elif defined(__aarch64__)
+    uint64_t v;
+    __asm__ __volatile__("isb\n\tmrs %0, cntvct_el0" : "=r"(v) : : "memory");
+    return v;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC_RAW, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+#endif
+}
+
+double cycles_per_ns = 0; // 由 cycles_calibrate 设置
+uint64_t cycles_overhead = 0; // 连续两次读计数器的最小间隔
+
+uint64_t cycles_clock_ns()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC_RAW, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+// 在 ms 毫秒内同时读取计数器与 CLOCK_MONOTONIC_RAW，求出计数器频率；返回每纳秒的周期数
+double cycles_calibrate(int ms)
+{
+    uint64_t t0 = cycles_clock_ns(), c0 = cycles_now();
+    uint64_t t1, c1;
+    do
+    {
+        t1 = cycles_clock_ns();
+        c1 = cycles_now();
+    } while (t1 - t0 < (uint64_t)ms * 1000000ULL);
+    cycles_per_ns = (double)(c1 - c0) / (double)(t1 - t0);
+    assert(cycles_per_ns > 0);
+
+    int i;
+    cycles_overhead = UINT64_MAX;
+    for (i = 0; i < 1000; i++)
+    {
+        uint64_t a = cycles_now();
+        uint64_t b = cycles_now();
+        if (b - a < cycles_overhead)
+            cycles_overhead = b - a;
+    }
+    return cycles_per_ns;
+}
+
+double cycles_to_ns(uint64_t c)
+{
+    if (cycles_per_ns == 0)
+        cycles_calibrate(5);
+    return (double)c / cycles_per_ns;
+}
+
+int cycles_cmp(const void *a, const void *b)
+{
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+    return x < y ? -1 : x > y;
+}
+
+// 第 p 百分位（0 <= p <= 100）；samples 必须已经排好序
+uint64_t cycles_percentile(uint64_t *samples, long n, double p)
+{
+    assert(n > 0);
+    long k = (long)(p / 100.0 * (n - 1) + 0.5);
+    return samples[k];
+}
+
+void cycles_report_header()
+{
+    printf("%-24s %10s %10s %10s %10s %10s %10s\n",
+           "test", "min", "p50", "p90", "p99", "p99.9", "max");
+}
+
+// 对样本排序并按纳秒输出各百分位数；每个样本包含 ops 次操作时按单次操作汇报
+void cycles_report(const char *name, uint64_t *samples, long n, int ops)
+{
+    qsort(samples, n, sizeof(uint64_t), cycles_cmp);
+    double pct[] = {0, 50, 90, 99, 99.9, 100};
+    int i;
+    printf("%-24s", name);
+    for (i = 0; i < 6; i++)
+        printf(" %10.1f", cycles_to_ns(cycles_percentile(samples, n, pct[i])) / ops);
+    printf("\n");
+}
+
+#endif // __cycles_h__
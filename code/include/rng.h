@@ -0,0 +1,221 @@
+#ifndef __rng_h__
+#define __rng_h__
+
+// 快速伪随机数生成器：xoshiro256++（Blackman & Vigna）
+// 与 libc 的 random() 相比：
+//   - 状态由调用者持有，无全局锁，每个线程可以各自拥有独立的流
+//   - rng_bounded() 使用 Lemire 的乘法+拒绝方法，在 [0, range) 上严格均匀，没有取模偏差
+//   - rng_jump() 把流前进 2^128 步，用于给多个线程切分互不重叠的子序列
+//   - rng_bulk_t 把多路状态按"结构数组"排布，批量生成时循环可被编译器向量化
+
+#include <stdint.h>
+
+typedef struct
+{
+    uint64_t s[4];
+} rng_t;
+
+uint64_t rng_rotl(uint64_t x, int k)
+{
+    return (x << k) | (x >> (64 - k));
+}
+
+// splitmix64：把一个 64 位种子展开成 xoshiro 的 256 位初始状态
+uint64_t rng_splitmix64(uint64_t *x)
+{
+    uint64_t z = (*x += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+void rng_seed(rng_t *r, uint64_t seed)
+{
+    int i;
+    for (i = 0; i < 4; i++)
+        r->s[i] = rng_splitmix64(&seed);
+}
+
+uint64_t rng_next(rng_t *r)
+{
+    uint64_t *s = r->s;
+    uint64_t result = rng_rotl(s[0] + s[3], 23) + s[0];
+    uint64_t t = s[1] << 17;
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = rng_rotl(s[3], 45);
+    return result;
+}
+
+// [0, 1) 上的双精度浮点数（取高 53 位）
+double rng_double(rng_t *r)
+{
+    return (rng_next(r) >> 11) * 0x1.0p-53;
+}
+
+// Lemire 无偏有界采样：返回 [0, range) 上均匀分布的整数
+// 128 位乘积的高 64 位即为结果；低 64 位落入偏差区间时才需要重抽，概率 < range / 2^64
+uint64_t rng_bounded_with(uint64_t x, uint64_t range, rng_t *r)
+{
+    __uint128_t m = (__uint128_t)x * range;
+    uint64_t l = (uint64_t)m;
+    if (l < range)
+    {
+        uint64_t t = -range % range; // 2^64 mod range
+        while (l < t)
+        {
+            x = rng_next(r);
+            m = (__uint128_t)x * range;
+            l = (uint64_t)m;
+        }
+    }
+    return m >> 64;
+}
+
+uint64_t rng_bounded(rng_t *r, uint64_t range)
+{
+    return rng_bounded_with(rng_next(r), range, r);
+}
+
+// 跳跃函数：等价于调用 rng_next() 2^128 次
+// 第 k 个线程从同一种子出发跳 k 次，即可得到互不重叠的独立流
+void rng_jump(rng_t *r)
+{
+    static const uint64_t JUMP[] = {0x180ec6d33cfd0abaULL, 0xd5a61266f0c9392cULL,
+                                    0xa9582618e03fc9aaULL, 0x39abdc4529b1661cULL};
+    uint64_t s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+    int i, b;
+    for (i = 0; i < 4; i++)
+    {
+        for (b = 0; b < 64; b++)
+        {
+            if (JUMP[i] & (1ULL << b))
+            {
+                s0 ^= r->s[0];
+                s1 ^= r->s[1];
+                s2 ^= r->s[2];
+                s3 ^= r->s[3];
+            }
+            rng_next(r);
+        }
+    }
+    r->s[0] = s0;
+    r->s[1] = s1;
+    r->s[2] = s2;
+    r->s[3] = s3;
+}
+
+// 随机单环（Sattolo 算法）：next[i] 是 i 的后继，从任一点出发沿 next 走 n 步恰好经过
+// 0..n-1 各一次再回到起点。与 Fisher-Yates 的唯一区别是 j 取自 [0, i) 而不是 [0, i]，
+// 这样得到的排列总是一个长度为 n 的环。指针追逐测试用它打乱访问顺序，让预取器猜不到下一个地址
+void rng_cycle(rng_t *r, uint32_t *next, size_t n)
+{
+    size_t i;
+    for (i = 0; i < n; i++)
+        next[i] = i;
+    for (i = n > 0 ? n - 1 : 0; i > 0; i--)
+    {
+        size_t j = rng_bounded(r, i);
+        uint32_t t = next[i];
+        next[i] = next[j];
+        next[j] = t;
+    }
+}
+
+// ---------------- 批量生成 ----------------
+
+#define RNG_LANES 8 // 8 路 64 位状态：AVX2 下正好两个 256 位寄存器
+
+typedef struct
+{
+    uint64_t s0[RNG_LANES];
+    uint64_t s1[RNG_LANES];
+    uint64_t s2[RNG_LANES];
+    uint64_t s3[RNG_LANES];
+    rng_t spare; // Lemire 拒绝时的补抽来源
+} rng_bulk_t;
+
+// 每一路是一个独立的跳跃流，因此批量结果与路数无关地保持均匀、可复现
+void rng_bulk_seed(rng_bulk_t *b, uint64_t seed)
+{
+    rng_t r;
+    rng_seed(&r, seed);
+    int i;
+    for (i = 0; i < RNG_LANES; i++)
+    {
+        rng_jump(&r);
+        b->s0[i] = r.s[0];
+        b->s1[i] = r.s[1];
+        b->s2[i] = r.s[2];
+        b->s3[i] = r.s[3];
+    }
+    rng_jump(&r);
+    b->spare = r;
+}
+
+// 对 RNG_LANES 路状态各推进一步，结果写入 out[0..RNG_LANES)
+// 循环体只有移位、异或、加法，路与路之间没有依赖，可被编译器向量化
+#define RNG_BULK_STEP(s0, s1, s2, s3, out)                        \
+    do                                                            \
+    {                                                             \
+        int _k;                                                   \
+        for (_k = 0; _k < RNG_LANES; _k++)                        \
+        {                                                         \
+            uint64_t _sum = s0[_k] + s3[_k];                      \
+            (out)[_k] = ((_sum << 23) | (_sum >> 41)) + s0[_k];   \
+            uint64_t _t = s1[_k] << 17;                           \
+            s2[_k] ^= s0[_k];                                     \
+            s3[_k] ^= s1[_k];                                     \
+            s1[_k] ^= s2[_k];                                     \
+            s0[_k] ^= s3[_k];                                     \
+            s2[_k] ^= _t;                                         \
+            s3[_k] = (s3[_k] << 45) | (s3[_k] >> 19);             \
+        }                                                         \
+    } while (0)
+
+// 批量抽奖：一次抽出 n 个 [0, range) 上的中奖号码
+// 第一遍把状态放进局部数组整批生成原始随机数，第二遍整批做 Lemire 映射；
+// 极少数落入偏差区间的值走 rng_bounded_with() 从 spare 流补抽
+void draw_winners(rng_bulk_t *b, uint64_t range, uint64_t *out, long n)
+{
+    uint64_t s0[RNG_LANES], s1[RNG_LANES], s2[RNG_LANES], s3[RNG_LANES];
+    int k;
+    for (k = 0; k < RNG_LANES; k++)
+    {
+        s0[k] = b->s0[k];
+        s1[k] = b->s1[k];
+        s2[k] = b->s2[k];
+        s3[k] = b->s3[k];
+    }
+    long i;
+    for (i = 0; i + RNG_LANES <= n; i += RNG_LANES)
+        RNG_BULK_STEP(s0, s1, s2, s3, out + i);
+    if (i < n)
+    {
+        uint64_t raw[RNG_LANES];
+        RNG_BULK_STEP(s0, s1, s2, s3, raw);
+        for (k = 0; i + k < n; k++)
+            out[i + k] = raw[k];
+    }
+    for (k = 0; k < RNG_LANES; k++)
+    {
+        b->s0[k] = s0[k];
+        b->s1[k] = s1[k];
+        b->s2[k] = s2[k];
+        b->s3[k] = s3[k];
+    }
+
+    for (i = 0; i < n; i++)
+    {
+        __uint128_t m = (__uint128_t)out[i] * range;
+        if ((uint64_t)m < range)
+            out[i] = rng_bounded_with(out[i], range, &b->spare);
+        else
+            out[i] = m >> 64;
+    }
+}
+
+#endif // __rng_h__
@@ -0,0 +1,178 @@
+#ifndef __slab_h__
+#define __slab_h__
+
+// 定长对象的 slab 池：适合链表节点、请求结构体这类在热路径上反复申请释放的小对象
+//   - 空闲对象串成单链表，next 指针就存放在对象自己的内存里，没有额外的头部
+//   - 池空了就 mmap 一整块 slab（默认 64KB），一次切成若干对象全部挂到空闲链表上
+//   - 同类对象紧挨着放在一起，遍历时每个缓存行能装下更多对象
+//
+// 用 SLAB_TYPE 为一个类型生成带类型的接口（池本身由一把锁保护）：
+//   SLAB_TYPE(node, struct node_t)
+//   struct node_t *n = node_alloc();
+//   node_free(n);
+// SLAB_TYPE_CACHED 额外给每个线程一个本地缓存：最多 SLAB_CACHE 个对象，
+// 申请释放只操作线程本地的链表，空了或满了才加锁与池成批交换 SLAB_BATCH 个对象。
+// 线程退出前应调用 name_flush() 把本地缓存还给池，否则这些对象只能等 slab_destroy。
+//
+// 对象的内存只在 slab_destroy 时整体还给内核。
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <pthread.h>
+#include <sys/mman.h>
+
+#define SLAB_BYTES (64 * 1024)
+#define SLAB_CACHE 64
+#define SLAB_BATCH 32
+
+typedef struct __slab_obj_t
+{
+    struct __slab_obj_t *next;
+} slab_obj_t;
+
+// 每个 slab 开头的头部，把池的所有 slab 串起来以便销毁
+typedef struct __slab_hdr_t
+{
+    struct __slab_hdr_t *next;
+    long pad; // 让对象从 16 字节对齐的位置开始
+} slab_hdr_t;
+
+typedef struct
+{
+    size_t size;      // 对象大小，至少能放下一个指针，按 8 字节对齐
+    slab_obj_t *free; // 空闲链表
+    slab_hdr_t *slabs;
+    long nslabs;
+    pthread_mutex_t lock;
+} slab_pool_t;
+
+typedef struct
+{
+    slab_obj_t *free;
+    int count;
+} slab_cache_t;
+
+#define SLAB_POOL_INIT(objsize) \
+    {((objsize) + 7) & ~(size_t)7, NULL, NULL, 0, PTHREAD_MUTEX_INITIALIZER}
+
+void slab_init(slab_pool_t *p, size_t objsize)
+{
+    slab_pool_t init = SLAB_POOL_INIT(objsize);
+    *p = init;
+}
+
+// 调用者持有锁：映射一个新的 slab，把其中的对象按地址顺序挂到空闲链表上
+void slab_refill(slab_pool_t *p)
+{
+    char *s = mmap(NULL, SLAB_BYTES, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    assert(s != MAP_FAILED);
+    slab_hdr_t *h = (slab_hdr_t *)s;
+    h->next = p->slabs;
+    p->slabs = h;
+    p->nslabs++;
+
+    long n = (SLAB_BYTES - sizeof(slab_hdr_t)) / p->size;
+    char *first = s + sizeof(slab_hdr_t);
+    long i;
+    for (i = 0; i < n - 1; i++)
+        ((slab_obj_t *)(first + i * p->size))->next = (slab_obj_t *)(first + (i + 1) * p->size);
+    ((slab_obj_t *)(first + (n - 1) * p->size))->next = p->free;
+    p->free = (slab_obj_t *)first;
+}
+
+void *slab_alloc(slab_pool_t *p)
+{
+    pthread_mutex_lock(&p->lock);
+    if (p->free == NULL)
+        slab_refill(p);
+    slab_obj_t *o = p->free;
+    p->free = o->next;
+    pthread_mutex_unlock(&p->lock);
+    return o;
+}
+
+void slab_free(slab_pool_t *p, void *obj)
+{
+    slab_obj_t *o = obj;
+    pthread_mutex_lock(&p->lock);
+    o->next = p->free;
+    p->free = o;
+    pthread_mutex_unlock(&p->lock);
+}
+
+void *slab_cache_alloc(slab_pool_t *p, slab_cache_t *c)
+{
+    if (c->free == NULL)
+    {
+        // 从池里一次取 SLAB_BATCH 个
+        pthread_mutex_lock(&p->lock);
+        while (c->count < SLAB_BATCH)
+        {
+            if (p->free == NULL)
+                slab_refill(p);
+            slab_obj_t *o = p->free;
+            p->free = o->next;
+            o->next = c->free;
+            c->free = o;
+            c->count++;
+        }
+        pthread_mutex_unlock(&p->lock);
+    }
+    slab_obj_t *o = c->free;
+    c->free = o->next;
+    c->count--;
+    return o;
+}
+
+// 把本地缓存的前 n 个对象还给池
+void slab_cache_drain(slab_pool_t *p, slab_cache_t *c, int n)
+{
+    pthread_mutex_lock(&p->lock);
+    while (n-- > 0 && c->free != NULL)
+    {
+        slab_obj_t *o = c->free;
+        c->free = o->next;
+        c->count--;
+        o->next = p->free;
+        p->free = o;
+    }
+    pthread_mutex_unlock(&p->lock);
+}
+
+void slab_cache_free(slab_pool_t *p, slab_cache_t *c, void *obj)
+{
+    if (c->count == SLAB_CACHE)
+        slab_cache_drain(p, c, SLAB_BATCH);
+    slab_obj_t *o = obj;
+    o->next = c->free;
+    c->free = o;
+    c->count++;
+}
+
+// 释放池的所有 slab；之后池里的任何对象都不能再访问
+void slab_destroy(slab_pool_t *p)
+{
+    while (p->slabs != NULL)
+    {
+        slab_hdr_t *next = p->slabs->next;
+        munmap(p->slabs, SLAB_BYTES);
+        p->slabs = next;
+    }
+    p->free = NULL;
+    p->nslabs = 0;
+}
+
+#define SLAB_TYPE(name, type)                                                 \
+    slab_pool_t name##_pool = SLAB_POOL_INIT(sizeof(type));                   \
+    type *name##_alloc() { return (type *)slab_alloc(&name##_pool); }         \
+    void name##_free(type *o) { slab_free(&name##_pool, o); }
+
+#define SLAB_TYPE_CACHED(name, type)                                          \
+    slab_pool_t name##_pool = SLAB_POOL_INIT(sizeof(type));                   \
+    __thread slab_cache_t name##_cache;                                       \
+    type *name##_alloc() { return (type *)slab_cache_alloc(&name##_pool, &name##_cache); } \
+    void name##_free(type *o) { slab_cache_free(&name##_pool, &name##_cache, o); } \
+    void name##_flush() { slab_cache_drain(&name##_pool, &name##_cache, SLAB_CACHE); }
+
+#endif // __slab_h__
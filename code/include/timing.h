@@ -0,0 +1,232 @@
+#ifndef __timing_h__
+#define __timing_h__
+
+// 高精度计时
+//   timing_ns()   CLOCK_MONOTONIC_RAW 的纳秒数：单调、不受 NTP 调整影响，分辨率为纳秒
+//   cycles_now()  cycles.h 中的周期计数器；第一次调用 Spin_ns（或 cycles_to_ns）时才与
+//                 CLOCK_MONOTONIC_RAW 比对校准 5ms，只用 GetTime 的程序不付这个代价；
+//                 需要更准时可以自己先调用 cycles_calibrate
+//   Spin_ns(ns)   忙等 ns 纳秒，循环中执行 pause（aarch64 上是 yield），
+//                 计数器频率不恒定（没有 invariant TSC）时改用 timing_ns
+//
+// 另外提供 HDR 风格的延迟直方图 hdr_hist_t：按 2 的幂分段，每段再均分 HDR_SUB 个桶，
+// 相对误差不超过 1/HDR_SUB，记录一个值是 O(1)，内存固定，可以合并，
+// 任何示例都可以把每次操作的延迟记进去，最后按百分位数输出。
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <assert.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#endif
+#include "cycles.h"
+
+uint64_t timing_ns()
+{
+    struct timespec ts;
+    int rc = clock_gettime(CLOCK_MONOTONIC_RAW, &ts);
+    assert(rc == 0);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static inline void cpu_relax()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    __asm__ __volatile__("yield" ::: "memory");
+#endif
+}
+
+// 计数器频率是否恒定：x86 看 CPUID 0x80000007 的 EDX 第 8 位，aarch64 的通用定时器总是恒定的
+int timing_invariant_tsc()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    unsigned a, b, c, d;
+    if (__get_cpuid(0x80000007, &a, &b, &c, &d) == 0)
+        return 0;
+    return (d >> 8) & 1;
+#elif defined(__aarch64__)
+    return 1;
+#else
+    return 0;
+#endif
+}
+
+int timing_tsc = -1; // 可以用周期计数器计时；-1 表示还没检查
+
+// 第一次需要周期计数器时才检查并校准
+void timing_setup()
+{
+    if (timing_tsc < 0)
+        timing_tsc = timing_invariant_tsc();
+    if (timing_tsc && cycles_per_ns == 0)
+        cycles_calibrate(5);
+}
+
+void Spin_ns(uint64_t ns)
+{
+    if (timing_tsc < 0 || (timing_tsc && cycles_per_ns == 0))
+    {
+        // 第一次调用：校准花掉的时间算在这次等待里
+        uint64_t t0 = timing_ns();
+        timing_setup();
+        uint64_t spent = timing_ns() - t0;
+        if (spent >= ns)
+            return;
+        ns -= spent;
+    }
+    if (timing_tsc)
+    {
+        uint64_t end = cycles_now() + (uint64_t)(ns * cycles_per_ns);
+        while (cycles_now() < end)
+            cpu_relax();
+    }
+    else
+    {
+        uint64_t end = timing_ns() + ns;
+        while (timing_ns() < end)
+            cpu_relax();
+    }
+}
+
+// ---------------- HDR 风格直方图 ----------------
+//
+// 值 v < 2 * HDR_SUB 时每个值一个桶；否则 v 落在 [2^b, 2^(b+1)) 中，
+// 取最高的 HDR_SUB_BITS + 1 位作为桶号：shift = b - HDR_SUB_BITS，桶 = shift * HDR_SUB + (v >> shift)
+
+#define HDR_SUB_BITS 7
+#define HDR_SUB      (1 << HDR_SUB_BITS)
+#define HDR_BUCKETS  ((64 - HDR_SUB_BITS + 1) * HDR_SUB)
+
+typedef struct
+{
+    uint64_t count;
+    uint64_t min;
+    uint64_t max;
+    double sum;
+    uint64_t counts[HDR_BUCKETS];
+} hdr_hist_t;
+
+void hdr_reset(hdr_hist_t *h)
+{
+    memset(h, 0, sizeof(*h));
+    h->min = UINT64_MAX;
+}
+
+hdr_hist_t *hdr_new()
+{
+    hdr_hist_t *h = malloc(sizeof(hdr_hist_t));
+    assert(h != NULL);
+    hdr_reset(h);
+    return h;
+}
+
+static inline int hdr_index(uint64_t v)
+{
+    int b = 63 - __builtin_clzll(v | 1);
+    int shift = b > HDR_SUB_BITS ? b - HDR_SUB_BITS : 0;
+    return shift * HDR_SUB + (int)(v >> shift);
+}
+
+// 桶中最大的值；报告百分位数时用它，宁可高估也不低估
+uint64_t hdr_bucket_high(int i)
+{
+    if (i < 2 * HDR_SUB)
+        return i;
+    int shift = i / HDR_SUB - 1;
+    return ((uint64_t)(i - shift * HDR_SUB) << shift) + ((1ULL << shift) - 1);
+}
+
+static inline void hdr_record(hdr_hist_t *h, uint64_t v)
+{
+    h->counts[hdr_index(v)]++;
+    h->count++;
+    h->sum += v;
+    if (v < h->min)
+        h->min = v;
+    if (v > h->max)
+        h->max = v;
+}
+
+void hdr_merge(hdr_hist_t *dst, hdr_hist_t *src)
+{
+    int i;
+    for (i = 0; i < HDR_BUCKETS; i++)
+        dst->counts[i] += src->counts[i];
+    dst->count += src->count;
+    dst->sum += src->sum;
+    if (src->min < dst->min)
+        dst->min = src->min;
+    if (src->max > dst->max)
+        dst->max = src->max;
+}
+
+// 第 p 百分位（0 <= p <= 100）
+uint64_t hdr_percentile(hdr_hist_t *h, double p)
+{
+    if (h->count == 0)
+        return 0;
+    if (p <= 0)
+        return h->min;
+    uint64_t want = (uint64_t)(p / 100.0 * h->count + 0.5);
+    if (want == 0)
+        want = 1;
+    uint64_t seen = 0;
+    int i;
+    for (i = 0; i < HDR_BUCKETS; i++)
+    {
+        seen += h->counts[i];
+        if (seen >= want)
+        {
+            uint64_t v = hdr_bucket_high(i);
+            return v < h->max ? v : h->max;
+        }
+    }
+    return h->max;
+}
+
+double hdr_mean(hdr_hist_t *h)
+{
+    return h->count > 0 ? h->sum / h->count : 0;
+}
+
+void hdr_report_header()
+{
+    printf("%-24s %10s %10s %10s %10s %10s %10s %10s\n",
+           "test", "mean", "min", "p50", "p90", "p99", "p99.9", "max");
+}
+
+// 一行汇报；scale 把记录的值换算成纳秒（记录纳秒时为 1，记录周期数时为 1 / cycles_per_ns）
+void hdr_report(const char *name, hdr_hist_t *h, double scale)
+{
+    double pct[] = {0, 50, 90, 99, 99.9, 100};
+    int i;
+    printf("%-24s %10.1f", name, hdr_mean(h) * scale);
+    for (i = 0; i < 6; i++)
+        printf(" %10.1f", (pct[i] >= 100 ? h->max : hdr_percentile(h, pct[i])) * scale);
+    printf("\n");
+}
+
+// HdrHistogram 式的完整分布：百分位数每行向 100 逼近一半（50, 75, 87.5, ...）
+void hdr_print_distribution(hdr_hist_t *h, double scale)
+{
+    printf("%12s %12s %12s %12s\n", "value(ns)", "percentile", "count", "1/(1-p)");
+    double p = 0;
+    while (1)
+    {
+        double v = hdr_percentile(h, p * 100) * scale;
+        uint64_t below = (uint64_t)(p * h->count + 0.5);
+        if (p < 1)
+            printf("%12.1f %12.6f %12lu %12.1f\n", v, p, (unsigned long)below, 1 / (1 - p));
+        if (below >= h->count || p >= 0.999999)
+            break;
+        p += (1 - p) / 2;
+    }
+    printf("%12.1f %12.6f %12lu %12s\n", h->max * scale, 1.0, (unsigned long)h->count, "inf");
+}
+
+#endif // __timing_h__
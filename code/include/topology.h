@@ -0,0 +1,179 @@
+#ifndef __topology_h__
+#define __topology_h__
+
+// 从 /sys/devices/system/cpu 读取 CPU 拓扑：在线 CPU、物理核、插槽以及最后一级缓存（LLC）
+// 某个文件读不到时（容器、非 Linux 系统）退化为"每个 CPU 独占一个核和一个缓存"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <assert.h>
+
+#define TOPO_MAX_CPUS 1024
+
+typedef struct
+{
+    int cpu;     // 内核中的 CPU 编号
+    int core;    // 所在物理核（超线程兄弟共享）
+    int package; // 所在插槽
+    int llc;     // 共享同一 LLC 的 CPU 中编号最小者，作为 LLC 的标识
+    int llc_kb;  // LLC 大小（KB），未知时为 0
+} topo_cpu_t;
+
+typedef struct
+{
+    int ncpus;
+    topo_cpu_t cpus[TOPO_MAX_CPUS];
+} topology_t;
+
+// 读取 sysfs 文件的第一行；失败返回 -1
+int topo_read(const char *path, char *buf, int len)
+{
+    FILE *fp = fopen(path, "r");
+    if (fp == NULL)
+        return -1;
+    if (fgets(buf, len, fp) == NULL)
+    {
+        fclose(fp);
+        return -1;
+    }
+    fclose(fp);
+    buf[strcspn(buf, "\n")] = '\0';
+    return 0;
+}
+
+int topo_read_int(const char *path, int def)
+{
+    char buf[64];
+    if (topo_read(path, buf, sizeof(buf)) < 0)
+        return def;
+    return atoi(buf);
+}
+
+// 解析 "0-3,8,10-11" 形式的 CPU 列表，set[i] = 1 表示 CPU i 在列表中；返回个数
+int topo_parse_list(const char *s, char *set)
+{
+    int n = 0;
+    memset(set, 0, TOPO_MAX_CPUS);
+    while (*s)
+    {
+        char *end;
+        int lo = strtol(s, &end, 10), hi = lo;
+        if (end == s)
+            break;
+        if (*end == '-')
+            hi = strtol(end + 1, &end, 10);
+        for (; lo <= hi && lo < TOPO_MAX_CPUS; lo++)
+            if (!set[lo])
+            {
+                set[lo] = 1;
+                n++;
+            }
+        s = *end == ',' ? end + 1 : end;
+    }
+    return n;
+}
+
+// 找编号最大的缓存层级（即 LLC），记录其大小与共享它的最小 CPU 编号
+void topo_llc(topo_cpu_t *c)
+{
+    char path[256], buf[4096], set[TOPO_MAX_CPUS];
+    int index, best_level = 0;
+    c->llc = c->cpu;
+    c->llc_kb = 0;
+    for (index = 0;; index++)
+    {
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/cache/index%d/level", c->cpu, index);
+        int level = topo_read_int(path, -1);
+        if (level < 0)
+            break;
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/cache/index%d/type", c->cpu, index);
+        if (topo_read(path, buf, sizeof(buf)) == 0 && strcmp(buf, "Instruction") == 0)
+            continue;
+        if (level < best_level)
+            continue;
+        best_level = level;
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/cache/index%d/size", c->cpu, index);
+        if (topo_read(path, buf, sizeof(buf)) == 0)
+            c->llc_kb = atoi(buf) * (strchr(buf, 'M') ? 1024 : 1);
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/cache/index%d/shared_cpu_list", c->cpu, index);
+        if (topo_read(path, buf, sizeof(buf)) == 0 && topo_parse_list(buf, set) > 0)
+        {
+            int i;
+            for (i = 0; i < TOPO_MAX_CPUS && !set[i]; i++)
+                ;
+            c->llc = i;
+        }
+    }
+}
+
+void topology_discover(topology_t *t)
+{
+    char buf[4096], set[TOPO_MAX_CPUS], path[256];
+    int i;
+    t->ncpus = 0;
+    if (topo_read("/sys/devices/system/cpu/online", buf, sizeof(buf)) < 0 || topo_parse_list(buf, set) == 0)
+    {
+        long n = sysconf(_SC_NPROCESSORS_ONLN);
+        memset(set, 0, sizeof(set));
+        for (i = 0; i < n && i < TOPO_MAX_CPUS; i++)
+            set[i] = 1;
+    }
+    for (i = 0; i < TOPO_MAX_CPUS; i++)
+    {
+        if (!set[i])
+            continue;
+        topo_cpu_t *c = &t->cpus[t->ncpus++];
+        c->cpu = i;
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/topology/physical_package_id", i);
+        c->package = topo_read_int(path, 0);
+        // core_id 只在插槽内唯一，这里用线程兄弟中的最小编号作为全局唯一的核标识
+        char sib[TOPO_MAX_CPUS];
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/topology/thread_siblings_list", i);
+        c->core = i;
+        if (topo_read(path, buf, sizeof(buf)) == 0 && topo_parse_list(buf, sib) > 0)
+        {
+            int j;
+            for (j = 0; j < TOPO_MAX_CPUS && !sib[j]; j++)
+                ;
+            c->core = j;
+        }
+        topo_llc(c);
+    }
+    assert(t->ncpus > 0);
+}
+
+// 在 t 中找一个与 cpu 不共享 LLC 的 CPU（其次不共享物理核）；找不到时返回另一个任意 CPU，只有一个 CPU 时返回它自己
+int topology_far_cpu(topology_t *t, int cpu, int skip)
+{
+    int i, me = 0, best = -1, best_rank = -1;
+    for (i = 0; i < t->ncpus; i++)
+        if (t->cpus[i].cpu == cpu)
+            me = i;
+    for (i = 0; i < t->ncpus; i++)
+    {
+        int k = (me + 1 + skip + i) % t->ncpus; // 从不同起点轮转，多个线程不会都挤到同一个 CPU 上
+        topo_cpu_t *c = &t->cpus[k];
+        int rank = c->cpu == cpu ? 0 : c->core == t->cpus[me].core ? 1 : c->llc == t->cpus[me].llc ? 2 : 3;
+        if (rank > best_rank)
+        {
+            best = c->cpu;
+            best_rank = rank;
+        }
+    }
+    return best;
+}
+
+void topology_print(topology_t *t)
+{
+    int i;
+    printf("%5s %5s %8s %5s %8s\n", "cpu", "core", "package", "llc", "llc-KB");
+    for (i = 0; i < t->ncpus; i++)
+    {
+        topo_cpu_t *c = &t->cpus[i];
+        printf("%5d %5d %8d %5d %8d\n", c->cpu, c->core, c->package, c->llc, c->llc_kb);
+    }
+}
+
+#endif // __topology_h__
@@ -0,0 +1,289 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <signal.h>
+#include <time.h>
+#include <sys/prctl.h>
+#include "../include/common_threads.h"
+#include "../include/timing.h"
+#include "../include/rng.h"
+
+// cpu.c grown into a background load generator for noisy-neighbour tests.
+//
+// Each of <threads> threads is pinned to its own CPU and held at <util>
+// percent busy by PWM: every <period> ms it works for util * period, then
+// sleeps until the next period starts. Periods are scheduled on an absolute
+// timeline, so a late wakeup shortens the following sleep instead of
+// drifting the whole schedule.
+//
+//   alu - four independent multiply/xorshift chains, no memory traffic
+//   mem - a random pointer chase over a private <mem> buffer, one cache line
+//         per step, dirtying every line it visits (misses + writebacks)
+//   mix - alternates alu and mem chunks
+//
+// At the end (or on Ctrl-C) each thread reports the CPU time it actually got
+// divided by wall time, its measured busy fraction, the work done and how
+// many periods started too late to fit their busy phase. Jitter is the
+// lateness of each period's wakeup against its schedule, collected in an HDR
+// histogram across all threads.
+//
+// usage: loadgen [-t threads] [-u util%] [-k alu|mem|mix] [-p period-ms]
+//                [-d seconds, 0 = until Ctrl-C] [-c cpu,cpu,...] [-m mem-MB]
+
+#define LINE       64
+#define ALU_CHUNK  1024 // iterations between clock checks, about 1us
+#define MEM_CHUNK  64   // cache lines between clock checks
+
+enum { K_ALU, K_MEM, K_MIX };
+const char *kernels[] = {"alu", "mem", "mix"};
+
+typedef struct {
+    uint64_t next;
+    uint64_t pad[LINE / sizeof(uint64_t) - 1];
+} line_t;
+
+typedef struct {
+    pthread_t  thread;
+    int        id;
+    int        cpu;
+    line_t    *buf;
+    uint64_t   pos;      // current line of the chase
+    uint64_t   work;     // chunks completed
+    uint64_t   periods;
+    uint64_t   overruns; // busy phase cut short by a late wakeup
+    uint64_t   busy_ns;
+    uint64_t   wall_ns;
+    uint64_t   cpu_ns;
+    hdr_hist_t *late;    // wakeup lateness, ns
+} worker_t;
+
+int kernel = K_ALU;
+double util = 1.0;
+uint64_t period_ns = 10000000;
+uint64_t mem_lines;
+volatile sig_atomic_t stop;
+volatile uint64_t sink;
+
+void
+on_signal(int sig)
+{
+    stop = 1;
+}
+
+uint64_t
+thread_cpu_ns(void)
+{
+    struct timespec ts;
+    int rc = clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    assert(rc == 0);
+    return (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+void
+alu_chunk(void)
+{
+    uint64_t a = sink | 1, b = a + 1, c = a + 2, d = a + 3;
+    int i;
+    for (i = 0; i < ALU_CHUNK; i++) {
+        a = a * 6364136223846793005ULL + 1442695040888963407ULL;
+        b ^= b << 13; b ^= b >> 7; b ^= b << 17;
+        c = c * 2862933555777941757ULL + 3037000493ULL;
+        d ^= d << 5; d ^= d >> 9; d ^= d << 23;
+    }
+    sink = a ^ b ^ c ^ d;
+}
+
+void
+mem_chunk(worker_t *w)
+{
+    uint64_t p = w->pos;
+    int i;
+    for (i = 0; i < MEM_CHUNK; i++) {
+        w->buf[p].pad[0]++;
+        p = w->buf[p].next;
+    }
+    w->pos = p;
+}
+
+// a random single cycle through every line (rng_cycle), so the chase visits
+// the whole buffer and the prefetcher cannot follow it
+void
+build_chase(worker_t *w)
+{
+    w->buf = malloc(mem_lines * sizeof(line_t));
+    uint32_t *next = malloc(mem_lines * sizeof(uint32_t));
+    assert(w->buf != NULL && next != NULL);
+    rng_t r;
+    rng_seed(&r, w->id + 1);
+    rng_cycle(&r, next, mem_lines);
+    uint64_t i;
+    for (i = 0; i < mem_lines; i++)
+        w->buf[i].next = next[i];
+    free(next);
+    w->pos = 0;
+}
+
+void
+busy_until(worker_t *w, uint64_t end)
+{
+    do {
+        if (kernel == K_ALU || (kernel == K_MIX && (w->work & 1) == 0))
+            alu_chunk();
+        else
+            mem_chunk(w);
+        w->work++;
+    } while (timing_ns() < end && !stop);
+}
+
+void *
+worker(void *arg)
+{
+    worker_t *w = arg;
+    // the default 50us timer slack would dominate the measured jitter
+    prctl(PR_SET_TIMERSLACK, 1UL);
+    if (kernel != K_ALU)
+        build_chase(w);
+
+    uint64_t busy = (uint64_t) (util * period_ns);
+    uint64_t c0 = thread_cpu_ns();
+    uint64_t t0 = timing_ns();
+    uint64_t next = t0;
+    while (!stop) {
+        uint64_t now = timing_ns();
+        hdr_record(w->late, now > next ? now - next : 0);
+        if (busy > 0) {
+            uint64_t end = now + busy;
+            if (end > next + period_ns) {
+                // woke too late to fit the busy phase in this period
+                end = next + period_ns;
+                if (busy < period_ns)
+                    w->overruns++;
+            }
+            busy_until(w, end);
+            w->busy_ns += timing_ns() - now;
+        }
+        w->periods++;
+        next += period_ns;
+        now = timing_ns();
+        if (now > next + period_ns) {
+            // lost more than a whole period (preempted); restart the schedule
+            next = now;
+        } else if (now < next) {
+            struct timespec ts;
+            uint64_t d = next - now;
+            ts.tv_sec = d / 1000000000ULL;
+            ts.tv_nsec = d % 1000000000ULL;
+            nanosleep(&ts, NULL);
+        }
+    }
+    w->wall_ns = timing_ns() - t0;
+    w->cpu_ns = thread_cpu_ns() - c0;
+    free(w->buf);
+    return NULL;
+}
+
+int
+parse_cpus(char *list, int *cpus, int max)
+{
+    int n = 0;
+    char *tok;
+    for (tok = strtok(list, ","); tok != NULL && n < max; tok = strtok(NULL, ","))
+        cpus[n++] = atoi(tok);
+    return n;
+}
+
+void
+usage(void)
+{
+    fprintf(stderr, "usage: loadgen [-t threads] [-u util%%] [-k alu|mem|mix] [-p period-ms]\n"
+                    "               [-d seconds] [-c cpu,cpu,...] [-m mem-MB]\n");
+    exit(1);
+}
+
+int main(int argc, char *argv[]) {
+    int ncpus = sysconf(_SC_NPROCESSORS_ONLN);
+    int nthreads = ncpus;
+    double seconds = 10, period_ms = 10, mem_mb = 64;
+    int cpus[1024], ncpu_list = 0;
+    int opt;
+    while ((opt = getopt(argc, argv, "t:u:k:p:d:c:m:")) != -1) {
+        switch (opt) {
+        case 't': nthreads = atoi(optarg); break;
+        case 'u': util = atof(optarg) / 100; break;
+        case 'p': period_ms = atof(optarg); break;
+        case 'd': seconds = atof(optarg); break;
+        case 'c': ncpu_list = parse_cpus(optarg, cpus, 1024); break;
+        case 'm': mem_mb = atof(optarg); break;
+        case 'k':
+            for (kernel = K_ALU; kernel <= K_MIX; kernel++)
+                if (strcmp(optarg, kernels[kernel]) == 0)
+                    break;
+            if (kernel > K_MIX)
+                usage();
+            break;
+        default: usage();
+        }
+    }
+    if (nthreads <= 0 || util < 0 || util > 1 || period_ms < 1 || seconds < 0 || mem_mb <= 0)
+        usage();
+    period_ns = (uint64_t) (period_ms * 1e6);
+    mem_lines = (uint64_t) (mem_mb * 1024 * 1024) / LINE;
+    if (mem_lines < 2)
+        usage();
+
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = on_signal;
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+
+    printf("%d threads, %.0f%% of each CPU, %s kernel, %.1f ms period", nthreads,
+           util * 100, kernels[kernel], period_ms);
+    if (kernel != K_ALU)
+        printf(", %.0f MB per thread", mem_mb);
+    printf("\n");
+
+    worker_t *w = calloc(nthreads, sizeof(worker_t));
+    assert(w != NULL);
+    int i;
+    for (i = 0; i < nthreads; i++) {
+        w[i].id = i;
+        w[i].cpu = ncpu_list > 0 ? cpus[i % ncpu_list] : i % ncpus;
+        w[i].late = hdr_new();
+        Pthread_create_on_cpu(&w[i].thread, w[i].cpu, worker, &w[i]);
+    }
+    if (seconds > 0) {
+        uint64_t end = timing_ns() + (uint64_t) (seconds * 1e9);
+        while (!stop && timing_ns() < end)
+            usleep(10000);
+        stop = 1;
+    } else {
+        while (!stop)
+            pause();
+    }
+
+    printf("\n%-6s %4s %8s %8s %12s %10s %10s\n", "thread", "cpu", "cpu%", "busy%",
+           "chunks/s", "periods", "overruns");
+    hdr_hist_t *all = hdr_new();
+    double total = 0;
+    for (i = 0; i < nthreads; i++) {
+        Pthread_join(w[i].thread, NULL);
+        double wall = w[i].wall_ns / 1e9;
+        printf("%-6d %4d %8.1f %8.1f %12.0f %10lu %10lu\n", i, w[i].cpu,
+               100.0 * w[i].cpu_ns / w[i].wall_ns, 100.0 * w[i].busy_ns / w[i].wall_ns,
+               w[i].work / wall, (unsigned long) w[i].periods, (unsigned long) w[i].overruns);
+        total += (double) w[i].cpu_ns / w[i].wall_ns;
+        hdr_merge(all, w[i].late);
+        free(w[i].late);
+    }
+    printf("total: %.2f CPUs busy (target %.2f)\n\n", total, util * nthreads);
+    printf("wakeup lateness (ns)\n");
+    hdr_report_header();
+    hdr_report("all threads", all, 1);
+    free(all);
+    free(w);
+    return 0;
+}
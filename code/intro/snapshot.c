@@ -0,0 +1,280 @@
+#include <unistd.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <sys/wait.h>
+#include <sys/resource.h>
+#include <pthread.h>
+#include "common.h"
+
+// mem.c grown into a checkpointing facility: a large in-memory table keeps
+// being mutated while a consistent snapshot of it is written to disk.
+//
+//   fork  - fork a child that writes the table as it was at fork time; the
+//           parent keeps mutating and copy-on-write preserves the child's view
+//   copy  - stop the world, memcpy the table, resume; a thread writes the copy
+//   write - stop the world and write the table directly
+//
+// Reported for each: how long the mutator was paused, how long the checkpoint
+// took, how many mutations happened meanwhile, the parent's minor page faults
+// (for fork these are the copy-on-write faults) and the extra memory needed.
+// Extra memory is measured, not inferred: the proportional set size (Pss in
+// /proc/<pid>/smaps_rollup) of the parent, plus the child's for fork, is
+// sampled every SAMPLE seconds while the snapshot runs, and the peak minus
+// the parent's Pss beforehand is reported. Pss splits shared pages between
+// the processes mapping them, so pages still shared after fork count once.
+// Every snapshot file is read back and checked against the table at snapshot time.
+
+#define PAGE   4096
+#define SAMPLE 0.01
+
+unsigned long *table;
+long entries;
+long hot;                 // mutations go to the first `hot` entries
+unsigned long rng = 88172645463325252UL;
+
+unsigned long
+next_rand(void)
+{
+    rng ^= rng << 13;
+    rng ^= rng >> 7;
+    rng ^= rng << 17;
+    return rng;
+}
+
+void
+mutate(long n)
+{
+    while (n-- > 0)
+        table[next_rand() % hot]++;
+}
+
+unsigned long
+checksum(unsigned long *t, long n)
+{
+    unsigned long h = 1469598103934665603UL;
+    long i;
+    for (i = 0; i < n; i++)
+        h = (h ^ t[i]) * 1099511628211UL;
+    return h;
+}
+
+void
+write_table(unsigned long *t, const char *path)
+{
+    int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, S_IRUSR | S_IWUSR);
+    assert(fd >= 0);
+    char *p = (char *) t;
+    long left = entries * sizeof(unsigned long);
+    while (left > 0) {
+        ssize_t rc = write(fd, p, left > (1 << 24) ? (1 << 24) : left);
+        assert(rc > 0);
+        p += rc;
+        left -= rc;
+    }
+    fsync(fd);
+    close(fd);
+}
+
+unsigned long
+file_checksum(const char *path)
+{
+    unsigned long *t = malloc(entries * sizeof(unsigned long));
+    assert(t != NULL);
+    int fd = open(path, O_RDONLY);
+    assert(fd >= 0);
+    char *p = (char *) t;
+    long left = entries * sizeof(unsigned long);
+    while (left > 0) {
+        ssize_t rc = read(fd, p, left);
+        assert(rc > 0);
+        p += rc;
+        left -= rc;
+    }
+    close(fd);
+    unsigned long h = checksum(t, entries);
+    free(t);
+    return h;
+}
+
+unsigned long *copy;
+char *path;
+int copy_written;
+
+void *
+copy_writer(void *arg)
+{
+    write_table(copy, path);
+    __atomic_store_n(&copy_written, 1, __ATOMIC_RELEASE);
+    return NULL;
+}
+
+long
+minor_faults(void)
+{
+    struct rusage ru;
+    int rc = getrusage(RUSAGE_SELF, &ru);
+    assert(rc == 0);
+    return ru.ru_minflt;
+}
+
+// proportional set size of a process in KB; -1 if it cannot be read
+// (no smaps_rollup before Linux 4.14, or the process has exited)
+long
+pss_kb(pid_t pid)
+{
+    char file[64], line[256];
+    snprintf(file, sizeof(file), "/proc/%d/smaps_rollup", (int) pid);
+    FILE *fp = fopen(file, "r");
+    if (fp == NULL)
+        return -1;
+    long kb = -1;
+    while (fgets(line, sizeof(line), fp) != NULL)
+        if (sscanf(line, "Pss: %ld kB", &kb) == 1)
+            break;
+    fclose(fp);
+    return kb;
+}
+
+// peak combined Pss of the parent and (if child > 0) the child
+long peak_kb;
+double next_sample;
+
+void
+sample_pss(pid_t child)
+{
+    double now = GetTime();
+    if (now < next_sample)
+        return;
+    next_sample = now + SAMPLE;
+    long kb = pss_kb(getpid());
+    if (child > 0) {
+        long c = pss_kb(child);
+        if (c < 0)
+            return;
+        kb += c;
+    }
+    if (kb > peak_kb)
+        peak_kb = kb;
+}
+
+void
+sample_start(void)
+{
+    peak_kb = -1;
+    next_sample = 0;
+}
+
+void
+report(const char *name, double pause, double total, long mutations, long faults, long base_kb)
+{
+    printf("%-6s %10.2f %10.2f %12ld %14.0f %10ld", name, pause * 1e3, total * 1e3,
+           mutations, total > 0 ? mutations / total : 0, faults);
+    if (base_kb >= 0 && peak_kb >= 0)
+        printf(" %10.1f\n", (peak_kb > base_kb ? peak_kb - base_kb : 0) / 1024.0);
+    else
+        printf(" %10s\n", "n/a");
+}
+
+int main(int argc, char *argv[]) {
+    if (argc != 4) {
+	fprintf(stderr, "usage: snapshot <table-MB> <hot-pct> <file>\n");
+	exit(1);
+    }
+    long mb = atol(argv[1]);
+    int hot_pct = atoi(argv[2]);
+    path = argv[3];
+    assert(mb > 0 && hot_pct > 0 && hot_pct <= 100);
+    entries = (mb << 20) / sizeof(unsigned long);
+    hot = entries / 100 * hot_pct;
+    if (hot == 0)
+	hot = 1;
+    table = malloc(entries * sizeof(unsigned long));
+    assert(table != NULL);
+    long i;
+    for (i = 0; i < entries; i++)
+	table[i] = i;
+
+    // mutator speed with nobody checkpointing, for reference
+    double t = GetTime();
+    mutate(10000000);
+    double base = 10000000 / (GetTime() - t);
+    printf("table: %ld MB, mutations hit the first %d%%, baseline %.0f mutations/sec\n\n",
+	   mb, hot_pct, base);
+    printf("%-6s %10s %10s %12s %14s %10s %10s\n",
+	   "method", "pause-ms", "total-ms", "mutations", "mutations/sec", "minflt", "extra-MB");
+
+    // 1. fork: the pause is the fork call itself (copying page tables)
+    unsigned long want = checksum(table, entries);
+    long faults = minor_faults();
+    long base_kb = pss_kb(getpid());
+    sample_start();
+    double start = GetTime();
+    int rc = fork();
+    double pause = GetTime() - start;
+    if (rc < 0) {
+	fprintf(stderr, "fork failed\n");
+	exit(1);
+    } else if (rc == 0) {
+	write_table(table, path);
+	_exit(0);
+    }
+    long mutations = 0;
+    while (waitpid(rc, NULL, WNOHANG) == 0) {
+	mutate(4096);
+	mutations += 4096;
+	sample_pss(rc);
+    }
+    double total = GetTime() - start;
+    faults = minor_faults() - faults;
+    // the copy-on-write copies are the extra memory, bounded by the hot set
+    report("fork", pause, total, mutations, faults, base_kb);
+    assert(file_checksum(path) == want);
+
+    // 2. stop the world, copy, resume; a second thread writes the copy meanwhile
+    want = checksum(table, entries);
+    faults = minor_faults();
+    base_kb = pss_kb(getpid());
+    sample_start();
+    start = GetTime();
+    copy = malloc(entries * sizeof(unsigned long));
+    assert(copy != NULL);
+    memcpy(copy, table, entries * sizeof(unsigned long));
+    pause = GetTime() - start;
+    pthread_t writer;
+    sample_pss(0);
+    copy_written = 0;
+    rc = pthread_create(&writer, NULL, copy_writer, NULL);
+    assert(rc == 0);
+    mutations = 0;
+    while (!__atomic_load_n(&copy_written, __ATOMIC_ACQUIRE)) {
+	mutate(4096);
+	mutations += 4096;
+	sample_pss(0);
+    }
+    rc = pthread_join(writer, NULL);
+    assert(rc == 0);
+    total = GetTime() - start;
+    faults = minor_faults() - faults;
+    report("copy", pause, total, mutations, faults, base_kb);
+    free(copy);
+    assert(file_checksum(path) == want);
+
+    // 3. stop the world for the whole write
+    want = checksum(table, entries);
+    faults = minor_faults();
+    base_kb = pss_kb(getpid());
+    sample_start();
+    start = GetTime();
+    write_table(table, path);
+    pause = total = GetTime() - start;
+    sample_pss(0);
+    faults = minor_faults() - faults;
+    report("write", pause, total, 0, faults, base_kb);
+    assert(file_checksum(path) == want);
+
+    unlink(path);
+    free(table);
+    return 0;
+}
@@ -3,6 +3,8 @@
 #include <pthread.h>
 // 引入封装的线程工具函数（含断言检查）
 #include "common_threads.h"
+// 定长对象的 slab 池
+#include "slab.h"
 
 // 定义线程输入参数结构体：传递给线程的多个参数
 typedef struct
@@ -18,6 +20,9 @@ typedef struct
     int y; // 返回结果y
 } myret_t;
 
+// myret_t 的 slab 池：生成 myret_alloc / myret_free，池由锁保护，可以在一个线程申请、另一个线程释放
+SLAB_TYPE(myret, myret_t)
+
 // 线程执行函数：接收myarg_t参数，处理后返回myret_t结果
 // 参数arg：输入参数（myarg_t*类型）
 void *mythread(void *arg)
@@ -27,8 +32,8 @@ void *mythread(void *arg)
     // 打印输入参数a和b的值
     printf("args %d %d\n", args->a, args->b);
 
-    // 动态分配返回值结构体（必须用malloc，避免栈内存随线程结束释放）
-    myret_t *rvals = malloc(sizeof(myret_t));
+    // 从堆上的 slab 池分配返回值结构体（不能放在栈上，栈会随线程结束释放）
+    myret_t *rvals = myret_alloc();
     assert(rvals != NULL); // 检查内存分配是否成功
 
     // 设置返回值内容
@@ -54,8 +59,8 @@ int main(int argc, char *argv[])
 
     // 打印线程返回的结果x和y
     printf("returned %d %d\n", rvals->x, rvals->y);
-    // 释放线程动态分配的内存（避免内存泄漏）
-    free(rvals);
+    // 把线程申请的结构体还给池（避免内存泄漏）
+    myret_free(rvals);
 
     return 0;
 }
\ No newline at end of file
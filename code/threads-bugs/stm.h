@@ -0,0 +1,194 @@
+#ifndef __stm_h__
+#define __stm_h__
+
+// TL2风格的字粒度软件事务内存（Software Transactional Memory）
+// 参考：Dice, Shalev, Shavit, "Transactional Locking II" (DISC 2006)
+//
+// 核心组成：
+//   1. 全局版本时钟 stm_clock：每个写事务提交时加一
+//   2. 条带化版本锁表 stm_locks：地址哈希到某一条带，条带字 = (版本号 << 1) | 锁位
+//   3. 读集/写集：读集记录读过的条带，写集缓冲待写入的 (地址, 值)
+//   4. 提交时校验：锁住写集 -> 递增时钟 -> 校验读集 -> 写回 -> 以新版本释放锁
+//   5. 冲突即中止：通过 longjmp 回到 STM_BEGIN 重新执行
+//
+// 用法（所有共享字都必须通过 STM_READ/STM_WRITE 访问）：
+//   STM_BEGIN(tx);
+//   long a = STM_READ(tx, &x);
+//   STM_WRITE(tx, &y, a + 1);
+//   STM_END(tx);
+
+#include <stdint.h>
+#include <setjmp.h>
+#include <sched.h>
+#include <assert.h>
+
+#define STM_LOCK_BITS  20                   // 锁表大小：2^20 个条带
+#define STM_LOCK_COUNT (1UL << STM_LOCK_BITS)
+#define STM_SET_MAX    4096                 // 单个事务的读集/写集上限
+
+typedef uint64_t stm_word_t;                // 条带锁字：(version << 1) | locked
+
+typedef struct
+{
+    long *addr; // 目标地址
+    long value; // 待写入的值
+    stm_word_t *lock; // 对应条带
+} stm_wentry_t;
+
+typedef struct
+{
+    jmp_buf env;              // 中止后跳回事务起点
+    uint64_t rv;              // 读版本：事务开始时的全局时钟
+    int nreads;
+    int nwrites;
+    int nlocked;              // 提交阶段已获取的条带数
+    stm_word_t *reads[STM_SET_MAX];
+    stm_wentry_t writes[STM_SET_MAX];
+    stm_word_t *locked[STM_SET_MAX];
+    unsigned long commits;    // 统计：成功提交次数
+    unsigned long aborts;     // 统计：中止（重试）次数
+} stm_tx_t;
+
+// 全局版本时钟与锁表（与头文件一起编译进唯一的翻译单元）
+volatile uint64_t stm_clock = 0;
+stm_word_t stm_locks[STM_LOCK_COUNT];
+
+// 地址 -> 条带：按8字节对齐的字地址做乘法哈希
+stm_word_t *stm_lock_of(long *addr)
+{
+    uintptr_t a = (uintptr_t)addr >> 3;
+    a *= 0x9E3779B97F4A7C15ULL;
+    return &stm_locks[a >> (64 - STM_LOCK_BITS)];
+}
+
+void stm_start(stm_tx_t *tx)
+{
+    tx->nreads = 0;
+    tx->nwrites = 0;
+    tx->nlocked = 0;
+    tx->rv = __atomic_load_n(&stm_clock, __ATOMIC_ACQUIRE);
+}
+
+// 释放提交阶段已获取的锁（恢复原版本号），然后跳回事务起点重试
+void stm_abort(stm_tx_t *tx)
+{
+    int i;
+    for (i = 0; i < tx->nlocked; i++)
+    {
+        stm_word_t v = __atomic_load_n(tx->locked[i], __ATOMIC_RELAXED);
+        __atomic_store_n(tx->locked[i], v & ~(stm_word_t)1, __ATOMIC_RELEASE);
+    }
+    tx->aborts++;
+    sched_yield(); // 简单退避，减少活锁
+    longjmp(tx->env, 1);
+}
+
+// 事务读：先查写集（读己之写），再做 "锁字-数据-锁字" 的一致性读
+long stm_read(stm_tx_t *tx, long *addr)
+{
+    int i;
+    for (i = tx->nwrites - 1; i >= 0; i--)
+        if (tx->writes[i].addr == addr)
+            return tx->writes[i].value;
+
+    stm_word_t *lock = stm_lock_of(addr);
+    stm_word_t pre = __atomic_load_n(lock, __ATOMIC_ACQUIRE);
+    long value = __atomic_load_n(addr, __ATOMIC_ACQUIRE);
+    stm_word_t post = __atomic_load_n(lock, __ATOMIC_ACQUIRE);
+    // 被锁住、读取期间被改写、或版本比读版本新：快照不一致，中止
+    if ((pre & 1) || pre != post || (pre >> 1) > tx->rv)
+        stm_abort(tx);
+
+    assert(tx->nreads < STM_SET_MAX);
+    tx->reads[tx->nreads++] = lock;
+    return value;
+}
+
+// 事务写：只缓冲到写集，提交时才真正写入内存
+void stm_write(stm_tx_t *tx, long *addr, long value)
+{
+    int i;
+    for (i = 0; i < tx->nwrites; i++)
+    {
+        if (tx->writes[i].addr == addr)
+        {
+            tx->writes[i].value = value;
+            return;
+        }
+    }
+    assert(tx->nwrites < STM_SET_MAX);
+    tx->writes[tx->nwrites].addr = addr;
+    tx->writes[tx->nwrites].value = value;
+    tx->writes[tx->nwrites].lock = stm_lock_of(addr);
+    tx->nwrites++;
+}
+
+// 判断某条带是否已被本事务锁住（多个地址可能落到同一条带）
+int stm_owns(stm_tx_t *tx, stm_word_t *lock)
+{
+    int i;
+    for (i = 0; i < tx->nlocked; i++)
+        if (tx->locked[i] == lock)
+            return 1;
+    return 0;
+}
+
+void stm_commit(stm_tx_t *tx)
+{
+    int i;
+    // 只读事务：读时已逐个校验，快照天然一致，直接提交
+    if (tx->nwrites == 0)
+    {
+        tx->commits++;
+        return;
+    }
+
+    // 1. 锁住写集中的所有条带；拿不到锁立即中止，不等待，因而不会死锁
+    for (i = 0; i < tx->nwrites; i++)
+    {
+        stm_word_t *lock = tx->writes[i].lock;
+        if (stm_owns(tx, lock))
+            continue;
+        stm_word_t v = __atomic_load_n(lock, __ATOMIC_RELAXED);
+        if ((v & 1) || (v >> 1) > tx->rv ||
+            !__atomic_compare_exchange_n(lock, &v, v | 1, 0,
+                                         __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+            stm_abort(tx);
+        tx->locked[tx->nlocked++] = lock;
+    }
+
+    // 2. 递增全局时钟，得到写版本
+    uint64_t wv = __atomic_add_fetch(&stm_clock, 1, __ATOMIC_ACQ_REL);
+
+    // 3. 校验读集：若期间没有其他写事务提交（rv + 1 == wv）则可跳过
+    if (tx->rv + 1 != wv)
+    {
+        for (i = 0; i < tx->nreads; i++)
+        {
+            stm_word_t v = __atomic_load_n(tx->reads[i], __ATOMIC_ACQUIRE);
+            if ((v >> 1) > tx->rv || ((v & 1) && !stm_owns(tx, tx->reads[i])))
+                stm_abort(tx);
+        }
+    }
+
+    // 4. 写回数据，5. 以写版本释放锁
+    for (i = 0; i < tx->nwrites; i++)
+        __atomic_store_n(tx->writes[i].addr, tx->writes[i].value, __ATOMIC_RELAXED);
+    for (i = 0; i < tx->nlocked; i++)
+        __atomic_store_n(tx->locked[i], wv << 1, __ATOMIC_RELEASE);
+    tx->nlocked = 0;
+    tx->commits++;
+}
+
+// 事务边界宏：setjmp 记录重试点，冲突中止后从这里重新执行事务体
+#define STM_BEGIN(tx)          \
+    do                         \
+    {                          \
+        setjmp((tx)->env);     \
+        stm_start(tx);         \
+    } while (0)
+#define STM_END(tx)            stm_commit(tx)
+#define STM_READ(tx, addr)     stm_read(tx, (long *)(addr))
+#define STM_WRITE(tx, addr, v) stm_write(tx, (long *)(addr), (long)(v))
+
+#endif // __stm_h__
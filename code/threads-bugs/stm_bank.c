@@ -0,0 +1,191 @@
+// 银行转账基准：对比三种多对象更新方式
+//   mutex   - 一把全局锁保护所有账户（无死锁，但完全串行）
+//   ordered - 每个账户一把锁，按账户编号顺序加锁（破坏循环等待，避免 deadlock.c 中的死锁）
+//   stm     - TL2 软件事务内存（无锁顺序约束，冲突时中止重试）
+// To compile: make stm_bank
+// To run:     ./stm_bank 1024 200000 8
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "common.h"
+#include "common_threads.h"
+#include "stm.h"
+
+#define INITIAL_BALANCE 1000
+
+typedef enum
+{
+    MODE_MUTEX,
+    MODE_ORDERED,
+    MODE_STM
+} sync_mode_t;
+
+const char *mode_names[] = {"mutex", "ordered", "stm"};
+
+int naccounts;
+int nops;
+sync_mode_t mode;
+
+long *accounts;                 // 账户余额（STM 以字为单位访问）
+pthread_mutex_t global_lock = PTHREAD_MUTEX_INITIALIZER;
+pthread_mutex_t *account_locks; // ordered 模式下每个账户一把锁
+
+typedef struct
+{
+    unsigned int seed;
+    unsigned long commits;
+    unsigned long aborts;
+} worker_t;
+
+// 在两个账户之间转账：余额不足则不转
+void transfer_mutex(int from, int to, long amount)
+{
+    Pthread_mutex_lock(&global_lock);
+    if (accounts[from] >= amount)
+    {
+        accounts[from] -= amount;
+        accounts[to] += amount;
+    }
+    Pthread_mutex_unlock(&global_lock);
+}
+
+// 总是先锁编号小的账户：所有线程的加锁顺序一致，不会形成环路
+void transfer_ordered(int from, int to, long amount)
+{
+    int first = from < to ? from : to;
+    int second = from < to ? to : from;
+    Pthread_mutex_lock(&account_locks[first]);
+    Pthread_mutex_lock(&account_locks[second]);
+    if (accounts[from] >= amount)
+    {
+        accounts[from] -= amount;
+        accounts[to] += amount;
+    }
+    Pthread_mutex_unlock(&account_locks[second]);
+    Pthread_mutex_unlock(&account_locks[first]);
+}
+
+void transfer_stm(stm_tx_t *tx, int from, int to, long amount)
+{
+    STM_BEGIN(tx);
+    long a = STM_READ(tx, &accounts[from]);
+    if (a >= amount)
+    {
+        long b = STM_READ(tx, &accounts[to]);
+        STM_WRITE(tx, &accounts[from], a - amount);
+        STM_WRITE(tx, &accounts[to], b + amount);
+    }
+    STM_END(tx);
+}
+
+void *worker(void *arg)
+{
+    worker_t *w = (worker_t *)arg;
+    stm_tx_t *tx = NULL;
+    if (mode == MODE_STM)
+    {
+        tx = calloc(1, sizeof(stm_tx_t));
+        assert(tx != NULL);
+    }
+    int i;
+    for (i = 0; i < nops; i++)
+    {
+        int from = rand_r(&w->seed) % naccounts;
+        int to = rand_r(&w->seed) % naccounts;
+        if (from == to)
+            to = (to + 1) % naccounts;
+        long amount = rand_r(&w->seed) % 100;
+        switch (mode)
+        {
+        case MODE_MUTEX:
+            transfer_mutex(from, to, amount);
+            break;
+        case MODE_ORDERED:
+            transfer_ordered(from, to, amount);
+            break;
+        case MODE_STM:
+            transfer_stm(tx, from, to, amount);
+            break;
+        }
+    }
+    if (tx != NULL)
+    {
+        w->commits = tx->commits;
+        w->aborts = tx->aborts;
+        free(tx);
+    }
+    return NULL;
+}
+
+// 运行一轮：返回每秒完成的转账数，并校验总余额守恒
+double run(int nthreads, unsigned long *aborts)
+{
+    int i;
+    for (i = 0; i < naccounts; i++)
+        accounts[i] = INITIAL_BALANCE;
+
+    pthread_t *threads = malloc(sizeof(pthread_t) * nthreads);
+    worker_t *workers = calloc(nthreads, sizeof(worker_t));
+    assert(threads != NULL && workers != NULL);
+
+    double start = GetTime();
+    for (i = 0; i < nthreads; i++)
+    {
+        workers[i].seed = i + 1;
+        Pthread_create(&threads[i], NULL, worker, &workers[i]);
+    }
+    for (i = 0; i < nthreads; i++)
+        Pthread_join(threads[i], NULL);
+    double elapsed = GetTime() - start;
+
+    long total = 0;
+    *aborts = 0;
+    for (i = 0; i < naccounts; i++)
+        total += accounts[i];
+    for (i = 0; i < nthreads; i++)
+        *aborts += workers[i].aborts;
+    // 任何一种方式都必须保证钱既不凭空产生也不凭空消失
+    assert(total == (long)naccounts * INITIAL_BALANCE);
+
+    free(threads);
+    free(workers);
+    return (double)nthreads * nops / elapsed;
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc != 4)
+    {
+        fprintf(stderr, "usage: stm_bank <accounts> <ops-per-thread> <max-threads>\n");
+        exit(1);
+    }
+    naccounts = atoi(argv[1]);
+    nops = atoi(argv[2]);
+    int maxthreads = atoi(argv[3]);
+    assert(naccounts >= 2 && nops > 0 && maxthreads > 0);
+
+    accounts = malloc(sizeof(long) * naccounts);
+    account_locks = malloc(sizeof(pthread_mutex_t) * naccounts);
+    assert(accounts != NULL && account_locks != NULL);
+    int i;
+    for (i = 0; i < naccounts; i++)
+        Mutex_init(&account_locks[i]);
+
+    printf("%8s %8s %14s %10s\n", "threads", "mode", "transfers/s", "aborts");
+    int nthreads;
+    for (nthreads = 1; nthreads <= maxthreads; nthreads *= 2)
+    {
+        for (mode = MODE_MUTEX; mode <= MODE_STM; mode++)
+        {
+            unsigned long aborts;
+            double rate = run(nthreads, &aborts);
+            printf("%8d %8s %14.0f %10lu\n", nthreads, mode_names[mode], rate, aborts);
+        }
+    }
+    free(accounts);
+    free(account_locks);
+    return 0;
+}
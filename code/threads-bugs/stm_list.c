@@ -0,0 +1,349 @@
+// 有序链表集合基准：insert/remove/contains 混合负载下对比
+//   mutex   - 一把全局锁保护整个链表
+//   ordered - 每个节点一把锁，沿链表方向逐个"手递手"加锁（hand-over-hand），
+//             所有线程都从表头向表尾加锁，顺序一致因此不会死锁
+//   stm     - TL2 软件事务内存，每次操作是一个事务
+// To compile: make stm_list
+// To run:     ./stm_list 1024 20 200000 8
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <limits.h>
+#include <pthread.h>
+
+#include "common.h"
+#include "common_threads.h"
+#include "stm.h"
+
+typedef enum
+{
+    MODE_MUTEX,
+    MODE_ORDERED,
+    MODE_STM
+} sync_mode_t;
+
+const char *mode_names[] = {"mutex", "ordered", "stm"};
+
+// 节点字段都是 long 宽度，便于 STM 按字读写（next 以整数形式存放指针）
+typedef struct node_t
+{
+    long key;
+    long next; // struct node_t *
+    pthread_mutex_t lock;
+} node_t;
+
+#define NEXT(n) ((node_t *)(n)->next)
+
+int keyrange;
+int update_pct; // 更新操作（插入+删除）所占百分比
+int nops;
+sync_mode_t mode;
+
+node_t *head; // 哨兵：key = LONG_MIN，表尾哨兵 key = LONG_MAX
+pthread_mutex_t global_lock = PTHREAD_MUTEX_INITIALIZER;
+
+typedef struct
+{
+    unsigned int seed;
+    long delta;        // 本线程成功插入数 - 成功删除数
+    node_t **retired;  // 被删除的节点：并发读者可能仍在访问，统一在运行结束后释放
+    int nretired;
+    int maxretired;
+    unsigned long aborts;
+} worker_t;
+
+node_t *node_new(long key, node_t *next)
+{
+    node_t *n = malloc(sizeof(node_t));
+    assert(n != NULL);
+    n->key = key;
+    n->next = (long)next;
+    Mutex_init(&n->lock);
+    return n;
+}
+
+void retire(worker_t *w, node_t *n)
+{
+    if (w->nretired == w->maxretired)
+    {
+        w->maxretired = w->maxretired ? w->maxretired * 2 : 64;
+        w->retired = realloc(w->retired, sizeof(node_t *) * w->maxretired);
+        assert(w->retired != NULL);
+    }
+    w->retired[w->nretired++] = n;
+}
+
+// ---------------- 全局锁版本 ----------------
+
+int list_op_mutex(worker_t *w, int op, long key)
+{
+    int result;
+    Pthread_mutex_lock(&global_lock);
+    node_t *prev = head;
+    node_t *curr = NEXT(prev);
+    while (curr->key < key)
+    {
+        prev = curr;
+        curr = NEXT(curr);
+    }
+    int found = (curr->key == key);
+    if (op == 0)
+        result = found;
+    else if (op == 1)
+    {
+        if (!found)
+            prev->next = (long)node_new(key, curr);
+        result = !found;
+    }
+    else
+    {
+        if (found)
+        {
+            prev->next = curr->next;
+            retire(w, curr);
+        }
+        result = found;
+    }
+    Pthread_mutex_unlock(&global_lock);
+    return result;
+}
+
+// ---------------- 手递手加锁版本 ----------------
+
+int list_op_ordered(worker_t *w, int op, long key)
+{
+    int result;
+    node_t *prev = head;
+    Pthread_mutex_lock(&prev->lock);
+    node_t *curr = NEXT(prev);
+    Pthread_mutex_lock(&curr->lock);
+    // 始终持有相邻两个节点的锁，先锁后继再放前驱
+    while (curr->key < key)
+    {
+        Pthread_mutex_unlock(&prev->lock);
+        prev = curr;
+        curr = NEXT(curr);
+        Pthread_mutex_lock(&curr->lock);
+    }
+    int found = (curr->key == key);
+    if (op == 0)
+        result = found;
+    else if (op == 1)
+    {
+        if (!found)
+            prev->next = (long)node_new(key, curr);
+        result = !found;
+    }
+    else
+    {
+        if (found)
+        {
+            prev->next = curr->next;
+            retire(w, curr);
+        }
+        result = found;
+    }
+    Pthread_mutex_unlock(&curr->lock);
+    Pthread_mutex_unlock(&prev->lock);
+    return result;
+}
+
+// ---------------- STM 版本 ----------------
+
+int list_op_stm(worker_t *w, stm_tx_t *tx, int op, long key)
+{
+    int result;
+    node_t *curr;
+    // 新节点在事务外分配：重试时复用，事务提交后才对其他线程可见
+    node_t *fresh = NULL;
+    if (op == 1)
+        fresh = node_new(key, NULL);
+
+    STM_BEGIN(tx);
+    node_t *prev = head;
+    curr = (node_t *)STM_READ(tx, &prev->next);
+    while (STM_READ(tx, &curr->key) < key)
+    {
+        prev = curr;
+        curr = (node_t *)STM_READ(tx, &curr->next);
+    }
+    int found = (STM_READ(tx, &curr->key) == key);
+    if (op == 0)
+        result = found;
+    else if (op == 1)
+    {
+        if (!found)
+        {
+            fresh->next = (long)curr;
+            STM_WRITE(tx, &prev->next, fresh);
+        }
+        result = !found;
+    }
+    else
+    {
+        if (found)
+            STM_WRITE(tx, &prev->next, STM_READ(tx, &curr->next));
+        result = found;
+    }
+    STM_END(tx);
+
+    if (op == 1 && !result)
+        free(fresh);
+    // 被删节点的 next 字段保持不变，正在遍历它的事务仍能走到表尾
+    if (op == 2 && result)
+        retire(w, curr);
+    return result;
+}
+
+void *worker(void *arg)
+{
+    worker_t *w = (worker_t *)arg;
+    stm_tx_t *tx = NULL;
+    if (mode == MODE_STM)
+    {
+        tx = calloc(1, sizeof(stm_tx_t));
+        assert(tx != NULL);
+    }
+    int i;
+    for (i = 0; i < nops; i++)
+    {
+        long key = rand_r(&w->seed) % keyrange;
+        int r = rand_r(&w->seed) % 100;
+        // op: 0 = contains, 1 = insert, 2 = remove
+        int op = (r < update_pct) ? 1 + (r & 1) : 0;
+        int changed = 0;
+        switch (mode)
+        {
+        case MODE_MUTEX:
+            changed = list_op_mutex(w, op, key);
+            break;
+        case MODE_ORDERED:
+            changed = list_op_ordered(w, op, key);
+            break;
+        case MODE_STM:
+            changed = list_op_stm(w, tx, op, key);
+            break;
+        }
+        if (op == 1 && changed)
+            w->delta++;
+        if (op == 2 && changed)
+            w->delta--;
+    }
+    if (tx != NULL)
+    {
+        w->aborts = tx->aborts;
+        free(tx);
+    }
+    return NULL;
+}
+
+void list_free()
+{
+    node_t *n = head;
+    while (n != NULL)
+    {
+        node_t *next = NEXT(n);
+        free(n);
+        n = next;
+    }
+}
+
+// 初始化链表：预先插入一半的键，哨兵位于两端
+long list_init()
+{
+    node_t *tail = node_new(LONG_MAX, NULL);
+    head = node_new(LONG_MIN, tail);
+    node_t *prev = head;
+    long size = 0;
+    long key;
+    for (key = 0; key < keyrange; key += 2)
+    {
+        prev->next = (long)node_new(key, tail);
+        prev = NEXT(prev);
+        size++;
+    }
+    return size;
+}
+
+// 校验：链表严格有序，且长度等于初始长度加上各线程的净插入数
+long list_check()
+{
+    long size = 0;
+    node_t *n = NEXT(head);
+    long last = LONG_MIN;
+    while (n->key != LONG_MAX)
+    {
+        assert(n->key > last);
+        last = n->key;
+        size++;
+        n = NEXT(n);
+    }
+    return size;
+}
+
+double run(int nthreads, unsigned long *aborts)
+{
+    long size = list_init();
+    pthread_t *threads = malloc(sizeof(pthread_t) * nthreads);
+    worker_t *workers = calloc(nthreads, sizeof(worker_t));
+    assert(threads != NULL && workers != NULL);
+
+    int i;
+    double start = GetTime();
+    for (i = 0; i < nthreads; i++)
+    {
+        workers[i].seed = i + 1;
+        Pthread_create(&threads[i], NULL, worker, &workers[i]);
+    }
+    for (i = 0; i < nthreads; i++)
+        Pthread_join(threads[i], NULL);
+    double elapsed = GetTime() - start;
+
+    *aborts = 0;
+    for (i = 0; i < nthreads; i++)
+    {
+        size += workers[i].delta;
+        *aborts += workers[i].aborts;
+    }
+    assert(list_check() == size);
+
+    list_free();
+    for (i = 0; i < nthreads; i++)
+    {
+        int j;
+        for (j = 0; j < workers[i].nretired; j++)
+            free(workers[i].retired[j]);
+        free(workers[i].retired);
+    }
+    free(threads);
+    free(workers);
+    return (double)nthreads * nops / elapsed;
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc != 5)
+    {
+        fprintf(stderr, "usage: stm_list <keyrange> <update-pct> <ops-per-thread> <max-threads>\n");
+        exit(1);
+    }
+    keyrange = atoi(argv[1]);
+    update_pct = atoi(argv[2]);
+    nops = atoi(argv[3]);
+    int maxthreads = atoi(argv[4]);
+    assert(keyrange > 0 && update_pct >= 0 && update_pct <= 100);
+    assert(nops > 0 && maxthreads > 0);
+
+    printf("%8s %8s %14s %10s\n", "threads", "mode", "ops/s", "aborts");
+    int nthreads;
+    for (nthreads = 1; nthreads <= maxthreads; nthreads *= 2)
+    {
+        for (mode = MODE_MUTEX; mode <= MODE_STM; mode++)
+        {
+            unsigned long aborts;
+            double rate = run(nthreads, &aborts);
+            printf("%8d %8s %14.0f %10lu\n", nthreads, mode_names[mode], rate, aborts);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,785 @@
+// 页面置换策略模拟器（对应 Pics-vm-beyondphys-policy 中的 looping / random / 80-20 / clock 图）
+//
+// 策略：
+//   fifo   - 先进先出，环形缓冲区
+//   random - 随机淘汰
+//   lru    - 最近最少使用：侵入式双向链表，命中时移到表头，淘汰表尾
+//   clock  - 时钟算法：每个页框一个引用位，指针扫过引用位为 1 的页框时清零
+//   2q     - 2Q（Johnson & Shasha）：新页先进 A1in（FIFO），被淘汰后只在 A1out 中留下页号；
+//            在 A1out 中再次被访问的页才进入 Am（LRU），挡住只访问一次的扫描
+//   arc    - ARC（Megiddo & Modha）：T1/T2 两个 LRU 加上各自的幽灵列表 B1/B2，
+//            目标大小 p 根据幽灵命中在"近期"与"频繁"之间自适应
+//   opt    - Belady 最优：淘汰下次使用最远的页；下次使用位置由一次反向扫描预先算出，
+//            驻留页放在以下次使用位置为键的索引最大堆中
+//
+// 所有页号先压缩成 0..U-1 的稠密编号（文件 trace 用一个开放寻址的散列表完成），
+// 之后各策略的 "散列表" 都是按页号直接索引的数组，每次访问 O(1)（opt 为 O(log C)）。
+// 一个页同一时刻最多在一个链表里，所以所有链表共用同一对 prev/next 数组。
+//
+// trace 是二进制文件，每个引用一个 32 位页号，用 mmap 读入；-w 直接在内存中生成负载，
+// 再加 -o 则把生成的 trace 写到文件。
+//
+// To compile: make
+// To run:     ./replace -w 8020 -u 100 -n 10000 -c 10,20,40,60,80,100
+//             ./replace -w loop -u 50 -n 100000000 -c 49 -p lru,clock,arc,opt
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "common.h"
+#include "rng.h"
+
+typedef enum
+{
+    P_FIFO,
+    P_RANDOM,
+    P_LRU,
+    P_CLOCK,
+    P_2Q,
+    P_ARC,
+    P_OPT,
+    P_COUNT
+} policy_t;
+
+const char *policy_names[] = {"fifo", "random", "lru", "clock", "2q", "arc", "opt"};
+
+uint32_t *trace; // 稠密页号
+long nrefs;
+long npages;     // 不同页的个数 U
+uint64_t seed = 1;
+
+// ---------------- 侵入式双向链表（所有链表共用 prev/next） ----------------
+
+int32_t *prev_of, *next_of;
+
+typedef struct
+{
+    int32_t head; // 最近使用（MRU）端
+    int32_t tail; // 最久未用（LRU）端
+    long size;
+} list_t;
+
+void list_init(list_t *l)
+{
+    l->head = l->tail = -1;
+    l->size = 0;
+}
+
+static inline void list_push_head(list_t *l, int32_t x)
+{
+    prev_of[x] = -1;
+    next_of[x] = l->head;
+    if (l->head >= 0)
+        prev_of[l->head] = x;
+    else
+        l->tail = x;
+    l->head = x;
+    l->size++;
+}
+
+static inline void list_remove(list_t *l, int32_t x)
+{
+    if (prev_of[x] >= 0)
+        next_of[prev_of[x]] = next_of[x];
+    else
+        l->head = next_of[x];
+    if (next_of[x] >= 0)
+        prev_of[next_of[x]] = prev_of[x];
+    else
+        l->tail = prev_of[x];
+    l->size--;
+}
+
+static inline int32_t list_pop_tail(list_t *l)
+{
+    int32_t x = l->tail;
+    assert(x >= 0);
+    list_remove(l, x);
+    return x;
+}
+
+void links_alloc()
+{
+    prev_of = malloc(sizeof(int32_t) * npages);
+    next_of = malloc(sizeof(int32_t) * npages);
+    assert(prev_of != NULL && next_of != NULL);
+}
+
+void links_free()
+{
+    free(prev_of);
+    free(next_of);
+}
+
+// ---------------- 各策略：返回命中次数 ----------------
+
+long run_fifo(long cache)
+{
+    uint8_t *in = calloc(npages, 1);
+    uint32_t *ring = malloc(sizeof(uint32_t) * cache);
+    assert(in != NULL && ring != NULL);
+    long hits = 0, used = 0, hand = 0, i;
+    for (i = 0; i < nrefs; i++)
+    {
+        uint32_t x = trace[i];
+        if (in[x])
+        {
+            hits++;
+            continue;
+        }
+        if (used < cache)
+            ring[used++] = x;
+        else
+        {
+            in[ring[hand]] = 0;
+            ring[hand] = x;
+            hand = hand + 1 == cache ? 0 : hand + 1;
+        }
+        in[x] = 1;
+    }
+    free(in);
+    free(ring);
+    return hits;
+}
+
+long run_random(long cache)
+{
+    int32_t *slot_of = malloc(sizeof(int32_t) * npages);
+    uint32_t *slots = malloc(sizeof(uint32_t) * cache);
+    assert(slot_of != NULL && slots != NULL);
+    memset(slot_of, 0xff, sizeof(int32_t) * npages);
+    rng_t rng;
+    rng_seed(&rng, seed);
+    long hits = 0, used = 0, i;
+    for (i = 0; i < nrefs; i++)
+    {
+        uint32_t x = trace[i];
+        if (slot_of[x] >= 0)
+        {
+            hits++;
+            continue;
+        }
+        long s;
+        if (used < cache)
+            s = used++;
+        else
+        {
+            s = rng_bounded(&rng, cache);
+            slot_of[slots[s]] = -1;
+        }
+        slots[s] = x;
+        slot_of[x] = s;
+    }
+    free(slot_of);
+    free(slots);
+    return hits;
+}
+
+long run_lru(long cache)
+{
+    uint8_t *in = calloc(npages, 1);
+    assert(in != NULL);
+    links_alloc();
+    list_t l;
+    list_init(&l);
+    long hits = 0, i;
+    for (i = 0; i < nrefs; i++)
+    {
+        uint32_t x = trace[i];
+        if (in[x])
+        {
+            hits++;
+            if (l.head != (int32_t)x)
+            {
+                list_remove(&l, x);
+                list_push_head(&l, x);
+            }
+            continue;
+        }
+        if (l.size == cache)
+            in[list_pop_tail(&l)] = 0;
+        list_push_head(&l, x);
+        in[x] = 1;
+    }
+    links_free();
+    free(in);
+    return hits;
+}
+
+long run_clock(long cache)
+{
+    int32_t *frame_of = malloc(sizeof(int32_t) * npages);
+    uint32_t *frames = malloc(sizeof(uint32_t) * cache);
+    uint8_t *ref = calloc(cache, 1);
+    assert(frame_of != NULL && frames != NULL && ref != NULL);
+    memset(frame_of, 0xff, sizeof(int32_t) * npages);
+    long hits = 0, used = 0, hand = 0, i;
+    for (i = 0; i < nrefs; i++)
+    {
+        uint32_t x = trace[i];
+        if (frame_of[x] >= 0)
+        {
+            hits++;
+            ref[frame_of[x]] = 1;
+            continue;
+        }
+        long f;
+        if (used < cache)
+            f = used++;
+        else
+        {
+            while (ref[hand])
+            {
+                ref[hand] = 0;
+                hand = hand + 1 == cache ? 0 : hand + 1;
+            }
+            f = hand;
+            frame_of[frames[f]] = -1;
+            hand = hand + 1 == cache ? 0 : hand + 1;
+        }
+        frames[f] = x;
+        frame_of[x] = f;
+        ref[f] = 1;
+    }
+    free(frame_of);
+    free(frames);
+    free(ref);
+    return hits;
+}
+
+enum { NOWHERE, IN_A1IN, IN_A1OUT, IN_AM, IN_T1, IN_T2, IN_B1, IN_B2 };
+
+long run_2q(long cache)
+{
+    uint8_t *where = calloc(npages, 1);
+    assert(where != NULL);
+    links_alloc();
+    list_t a1in, a1out, am;
+    list_init(&a1in);
+    list_init(&a1out);
+    list_init(&am);
+    long kin = cache / 4 > 0 ? cache / 4 : 1;
+    long kout = cache / 2 > 0 ? cache / 2 : 1;
+    long hits = 0, i;
+    for (i = 0; i < nrefs; i++)
+    {
+        uint32_t x = trace[i];
+        if (where[x] == IN_AM)
+        {
+            hits++;
+            list_remove(&am, x);
+            list_push_head(&am, x);
+            continue;
+        }
+        if (where[x] == IN_A1IN)
+        {
+            hits++; // 仍在 FIFO 中，不改变位置
+            continue;
+        }
+        // 未命中：先记下是否在 A1out 中，腾页框时 A1out 的修剪可能恰好把 x 挤掉
+        int seen = where[x] == IN_A1OUT;
+        if (seen)
+            list_remove(&a1out, x);
+        if (a1in.size + am.size >= cache)
+        {
+            if (a1in.size > kin || am.size == 0)
+            {
+                int32_t y = list_pop_tail(&a1in);
+                list_push_head(&a1out, y);
+                where[y] = IN_A1OUT;
+                if (a1out.size > kout)
+                    where[list_pop_tail(&a1out)] = NOWHERE;
+            }
+            else
+                where[list_pop_tail(&am)] = NOWHERE;
+        }
+        if (seen)
+        {
+            list_push_head(&am, x);
+            where[x] = IN_AM;
+        }
+        else
+        {
+            list_push_head(&a1in, x);
+            where[x] = IN_A1IN;
+        }
+    }
+    links_free();
+    free(where);
+    return hits;
+}
+
+list_t t1, t2, b1, b2;
+uint8_t *arc_where;
+long arc_p;
+
+void arc_move(list_t *from, list_t *to, int32_t x, int tag)
+{
+    list_remove(from, x);
+    list_push_head(to, x);
+    arc_where[x] = tag;
+}
+
+// 从 T1 或 T2 淘汰一页到对应的幽灵列表
+void arc_replace(int x_in_b2)
+{
+    if (t1.size > 0 && (t1.size > arc_p || (x_in_b2 && t1.size == arc_p)))
+        arc_move(&t1, &b1, t1.tail, IN_B1);
+    else
+        arc_move(&t2, &b2, t2.tail, IN_B2);
+}
+
+long run_arc(long cache)
+{
+    arc_where = calloc(npages, 1);
+    assert(arc_where != NULL);
+    links_alloc();
+    list_init(&t1);
+    list_init(&t2);
+    list_init(&b1);
+    list_init(&b2);
+    arc_p = 0;
+    long hits = 0, i;
+    for (i = 0; i < nrefs; i++)
+    {
+        uint32_t x = trace[i];
+        switch (arc_where[x])
+        {
+        case IN_T1:
+            hits++;
+            arc_move(&t1, &t2, x, IN_T2);
+            break;
+        case IN_T2:
+            hits++;
+            if (t2.head != (int32_t)x)
+                arc_move(&t2, &t2, x, IN_T2);
+            break;
+        case IN_B1:
+        {
+            long d = b2.size / b1.size > 1 ? b2.size / b1.size : 1;
+            arc_p = arc_p + d < cache ? arc_p + d : cache;
+            arc_replace(0);
+            arc_move(&b1, &t2, x, IN_T2);
+            break;
+        }
+        case IN_B2:
+        {
+            long d = b1.size / b2.size > 1 ? b1.size / b2.size : 1;
+            arc_p = arc_p - d > 0 ? arc_p - d : 0;
+            arc_replace(1);
+            arc_move(&b2, &t2, x, IN_T2);
+            break;
+        }
+        default:
+            if (t1.size + b1.size == cache)
+            {
+                if (t1.size < cache)
+                {
+                    arc_where[list_pop_tail(&b1)] = NOWHERE;
+                    arc_replace(0);
+                }
+                else
+                    arc_where[list_pop_tail(&t1)] = NOWHERE;
+            }
+            else
+            {
+                long total = t1.size + t2.size + b1.size + b2.size;
+                if (total >= cache)
+                {
+                    if (total == 2 * cache)
+                        arc_where[list_pop_tail(&b2)] = NOWHERE;
+                    arc_replace(0);
+                }
+            }
+            list_push_head(&t1, x);
+            arc_where[x] = IN_T1;
+        }
+    }
+    links_free();
+    free(arc_where);
+    return hits;
+}
+
+// opt：索引最大堆，键为页的下一次使用位置（从不再用时为 nrefs）
+uint32_t *next_use; // next_use[i]：trace[i] 之后同一页下一次出现的位置
+uint32_t *heap;
+int32_t *heap_pos;
+uint32_t *key_of;   // 驻留页当前的键
+long heap_size;
+
+// 反向扫描一次，算出每个引用的下一次使用位置
+void build_next_use()
+{
+    uint32_t *last = malloc(sizeof(uint32_t) * npages);
+    next_use = malloc(sizeof(uint32_t) * nrefs);
+    assert(last != NULL && next_use != NULL);
+    long i;
+    for (i = 0; i < npages; i++)
+        last[i] = (uint32_t)nrefs;
+    for (i = nrefs - 1; i >= 0; i--)
+    {
+        next_use[i] = last[trace[i]];
+        last[trace[i]] = (uint32_t)i;
+    }
+    free(last);
+}
+
+static inline void heap_set(long i, uint32_t x)
+{
+    heap[i] = x;
+    heap_pos[x] = i;
+}
+
+void heap_up(long i)
+{
+    uint32_t x = heap[i];
+    while (i > 0 && key_of[heap[(i - 1) / 2]] < key_of[x])
+    {
+        heap_set(i, heap[(i - 1) / 2]);
+        i = (i - 1) / 2;
+    }
+    heap_set(i, x);
+}
+
+void heap_down(long i)
+{
+    uint32_t x = heap[i];
+    for (;;)
+    {
+        long c = 2 * i + 1;
+        if (c >= heap_size)
+            break;
+        if (c + 1 < heap_size && key_of[heap[c + 1]] > key_of[heap[c]])
+            c++;
+        if (key_of[heap[c]] <= key_of[x])
+            break;
+        heap_set(i, heap[c]);
+        i = c;
+    }
+    heap_set(i, x);
+}
+
+long run_opt(long cache)
+{
+    heap = malloc(sizeof(uint32_t) * cache);
+    heap_pos = malloc(sizeof(int32_t) * npages);
+    key_of = malloc(sizeof(uint32_t) * npages);
+    assert(heap != NULL && heap_pos != NULL && key_of != NULL);
+    memset(heap_pos, 0xff, sizeof(int32_t) * npages);
+    heap_size = 0;
+    long hits = 0, i;
+    for (i = 0; i < nrefs; i++)
+    {
+        uint32_t x = trace[i];
+        if (heap_pos[x] >= 0)
+        {
+            hits++;
+            key_of[x] = next_use[i]; // 键只会变大：上浮
+            heap_up(heap_pos[x]);
+            continue;
+        }
+        key_of[x] = next_use[i];
+        if (heap_size == cache)
+        {
+            // 缺页的页总要调入，淘汰驻留页中下次使用最远的一个
+            heap_pos[heap[0]] = -1;
+            heap_set(0, x);
+            heap_down(0);
+        }
+        else
+        {
+            heap_set(heap_size, x);
+            heap_size++;
+            heap_up(heap_size - 1);
+        }
+    }
+    free(heap);
+    free(heap_pos);
+    free(key_of);
+    return hits;
+}
+
+// 用手算过的小 trace 检查 opt：
+//   1,2,1 缓存 1 页：每次都缺页，0 次命中
+//   教材中的例子 0,1,2,0,1,3,0,3,1,2,1 缓存 3 页：6 次命中
+void opt_selfcheck()
+{
+    static uint32_t t1[] = {1, 2, 1};
+    static uint32_t t2[] = {0, 1, 2, 0, 1, 3, 0, 3, 1, 2, 1};
+    uint32_t *saved_trace = trace;
+    long saved_nrefs = nrefs, saved_npages = npages;
+
+    trace = t1, nrefs = 3, npages = 3;
+    build_next_use();
+    assert(run_opt(1) == 0);
+    free(next_use);
+
+    trace = t2, nrefs = 11, npages = 4;
+    build_next_use();
+    assert(run_opt(3) == 6);
+    free(next_use);
+
+    trace = saved_trace, nrefs = saved_nrefs, npages = saved_npages;
+}
+
+long (*runners[])(long) = {run_fifo, run_random, run_lru, run_clock, run_2q, run_arc, run_opt};
+
+// ---------------- 负载 ----------------
+
+typedef enum
+{
+    W_LOOP,
+    W_RANDOM,
+    W_8020
+} workload_t;
+
+const char *workload_names[] = {"loop", "random", "8020"};
+
+// 与教材中的图一致：loop 依次循环访问 U 个页；random 均匀随机；
+// 8020 中 80% 的引用落在 20% 的热页上，其余 20% 落在另外 80% 的页上
+void generate(workload_t w)
+{
+    trace = malloc(sizeof(uint32_t) * nrefs);
+    assert(trace != NULL);
+    rng_t rng;
+    rng_seed(&rng, seed);
+    long hot = npages / 5 > 0 ? npages / 5 : 1;
+    long i;
+    for (i = 0; i < nrefs; i++)
+    {
+        if (w == W_LOOP)
+            trace[i] = i % npages;
+        else if (w == W_RANDOM)
+            trace[i] = rng_bounded(&rng, npages);
+        else if (rng_bounded(&rng, 100) < 80 || hot == npages)
+            trace[i] = rng_bounded(&rng, hot);
+        else
+            trace[i] = hot + rng_bounded(&rng, npages - hot);
+    }
+}
+
+// 把任意 32 位页号压缩成稠密编号：开放寻址散列表，键为页号 + 1（0 表示空槽），
+// 装填因子超过 1/2 时容量翻倍
+uint64_t *map_keys;
+uint32_t *map_vals;
+long map_cap;
+
+long map_slot(uint64_t k)
+{
+    uint64_t h = (k * 0x9e3779b97f4a7c15ULL) >> 20;
+    while (map_keys[h & (map_cap - 1)] != 0 && map_keys[h & (map_cap - 1)] != k)
+        h++;
+    return h & (map_cap - 1);
+}
+
+void map_alloc(long cap)
+{
+    map_cap = cap;
+    map_keys = calloc(cap, sizeof(uint64_t));
+    map_vals = malloc(sizeof(uint32_t) * cap);
+    assert(map_keys != NULL && map_vals != NULL);
+}
+
+void map_grow()
+{
+    uint64_t *keys = map_keys;
+    uint32_t *vals = map_vals;
+    long cap = map_cap, i;
+    map_alloc(cap * 2);
+    for (i = 0; i < cap; i++)
+        if (keys[i] != 0)
+        {
+            long s = map_slot(keys[i]);
+            map_keys[s] = keys[i];
+            map_vals[s] = vals[i];
+        }
+    free(keys);
+    free(vals);
+}
+
+void compact(uint32_t *raw)
+{
+    trace = malloc(sizeof(uint32_t) * nrefs);
+    assert(trace != NULL);
+    map_alloc(1 << 16);
+    npages = 0;
+    long i;
+    for (i = 0; i < nrefs; i++)
+    {
+        uint64_t k = (uint64_t)raw[i] + 1;
+        long s = map_slot(k);
+        if (map_keys[s] == 0)
+        {
+            if (2 * (npages + 1) > map_cap)
+            {
+                map_grow();
+                s = map_slot(k);
+            }
+            map_keys[s] = k;
+            map_vals[s] = npages++;
+        }
+        trace[i] = map_vals[s];
+    }
+    free(map_keys);
+    free(map_vals);
+}
+
+void usage()
+{
+    fprintf(stderr, "usage: replace (-f trace | -w loop|random|8020 [-u unique-pages] [-n refs] [-s seed] [-o out])\n"
+                    "               [-c cache-sizes] [-p policies]\n"
+                    "  cache-sizes and policies are comma-separated, e.g. -c 10,50,100 -p lru,clock,opt\n");
+    exit(1);
+}
+
+int main(int argc, char *argv[])
+{
+    char *tracefile = NULL, *outfile = NULL, *sizes = NULL, *policies = NULL;
+    int w = -1;
+    npages = 100;
+    nrefs = 10000;
+    int opt;
+    while ((opt = getopt(argc, argv, "f:w:u:n:s:o:c:p:")) != -1)
+    {
+        switch (opt)
+        {
+        case 'f': tracefile = optarg; break;
+        case 'u': npages = atol(optarg); break;
+        case 'n': nrefs = atol(optarg); break;
+        case 's': seed = atol(optarg); break;
+        case 'o': outfile = optarg; break;
+        case 'c': sizes = optarg; break;
+        case 'p': policies = optarg; break;
+        case 'w':
+            for (w = W_LOOP; w <= W_8020; w++)
+                if (strcmp(optarg, workload_names[w]) == 0)
+                    break;
+            if (w > W_8020)
+                usage();
+            break;
+        default:
+            usage();
+        }
+    }
+    if ((tracefile == NULL) == (w < 0))
+        usage();
+
+    double t = GetTime();
+    if (tracefile)
+    {
+        int fd = open(tracefile, O_RDONLY);
+        if (fd < 0)
+        {
+            perror(tracefile);
+            exit(1);
+        }
+        struct stat st;
+        assert(fstat(fd, &st) == 0);
+        nrefs = st.st_size / sizeof(uint32_t);
+        assert(nrefs > 0 && nrefs < UINT32_MAX);
+        uint32_t *raw = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        assert(raw != MAP_FAILED);
+        compact(raw);
+        munmap(raw, st.st_size);
+        close(fd);
+    }
+    else
+    {
+        assert(npages > 0 && npages < INT32_MAX && nrefs > 0 && nrefs < UINT32_MAX);
+        generate(w);
+        if (outfile)
+        {
+            FILE *fp = fopen(outfile, "w");
+            assert(fp != NULL);
+            assert(fwrite(trace, sizeof(uint32_t), nrefs, fp) == (size_t)nrefs);
+            fclose(fp);
+            return 0;
+        }
+    }
+    double load_time = GetTime() - t;
+
+    int enabled[P_COUNT];
+    int p;
+    for (p = 0; p < P_COUNT; p++)
+        enabled[p] = policies == NULL;
+    for (policies = policies ? strtok(policies, ",") : NULL; policies; policies = strtok(NULL, ","))
+    {
+        for (p = 0; p < P_COUNT; p++)
+            if (strcmp(policies, policy_names[p]) == 0)
+                break;
+        if (p == P_COUNT)
+            usage();
+        enabled[p] = 1;
+    }
+
+    // 默认的缓存大小：U 的 10%、20% ... 100%
+    long cache_sizes[256];
+    int ncache = 0;
+    if (sizes)
+    {
+        char *s;
+        for (s = strtok(sizes, ","); s && ncache < 256; s = strtok(NULL, ","))
+            cache_sizes[ncache++] = atol(s);
+    }
+    else
+    {
+        int k;
+        for (k = 1; k <= 10; k++)
+            cache_sizes[ncache++] = npages * k / 10 > 0 ? npages * k / 10 : 1;
+    }
+
+    double opt_prep = 0;
+    if (enabled[P_OPT])
+    {
+        opt_selfcheck();
+        t = GetTime();
+        build_next_use();
+        opt_prep = GetTime() - t;
+    }
+
+    printf("refs: %ld  unique pages: %ld  (load %.2f s", nrefs, npages, load_time);
+    if (enabled[P_OPT])
+        printf(", opt next-use pass %.2f s", opt_prep);
+    printf(")\n\nhit rate (%%)\n%8s", "cache");
+    for (p = 0; p < P_COUNT; p++)
+        if (enabled[p])
+            printf(" %8s", policy_names[p]);
+    printf("\n");
+
+    double elapsed[P_COUNT] = {0};
+    int c;
+    for (c = 0; c < ncache; c++)
+    {
+        long cache = cache_sizes[c];
+        assert(cache > 0);
+        printf("%8ld", cache);
+        for (p = 0; p < P_COUNT; p++)
+        {
+            if (!enabled[p])
+                continue;
+            t = GetTime();
+            long hits = runners[p](cache);
+            elapsed[p] += GetTime() - t;
+            printf(" %8.2f", 100.0 * hits / nrefs);
+        }
+        printf("\n");
+        fflush(stdout);
+    }
+
+    printf("\nspeed (M refs/sec)\n%8s", "");
+    for (p = 0; p < P_COUNT; p++)
+        if (enabled[p])
+            printf(" %8.1f", nrefs * (double)ncache / elapsed[p] / 1e6);
+    printf("\n");
+
+    free(trace);
+    if (enabled[P_OPT])
+        free(next_use);
+    return 0;
+}
@@ -0,0 +1,119 @@
+#ifndef __buddy_h__
+#define __buddy_h__
+
+// 二进制伙伴系统：每个 arena 是一个 2^FS_ARENA_LOG 字节的块，
+// 申请时取不小于请求的最小 2^k 块，没有就把更大的块一分为二，直到大小合适；
+// 释放时检查伙伴（地址只差第 k 位的那个块）是否空闲且同阶，是就合并，逐级向上。
+// arena 按自身大小对齐，所以伙伴地址可以直接由块地址异或 2^k 得到。
+//
+// 块布局：
+//   [未用][tag = (阶数 << 4) | FS_INUSE][用户数据 ...]
+// 空闲块清除 FS_INUSE，用户数据区存放双向链表指针 fd / bk。
+// 伙伴一定从某个块的起始地址开始，所以它的 tag 总是有效的。
+
+typedef struct __buddy_block_t
+{
+    size_t unused;
+    size_t tag;
+    struct __buddy_block_t *fd;
+    struct __buddy_block_t *bk;
+} buddy_block_t;
+
+#define BUDDY_MIN  5            // 最小块 32 字节
+#define BUDDY_MAX  FS_ARENA_LOG
+#define BUDDY_TRIM 20           // 2^20 = FS_TRIM
+
+buddy_block_t *buddy_lists[BUDDY_MAX + 1];
+uint32_t buddy_map; // 非空链表的位图
+
+#define buddy_order(b) ((int)((b)->tag >> 4))
+
+void buddy_push(buddy_block_t *b, int k)
+{
+    b->tag = (size_t)k << 4;
+    b->bk = NULL;
+    b->fd = buddy_lists[k];
+    if (b->fd != NULL)
+        b->fd->bk = b;
+    buddy_lists[k] = b;
+    buddy_map |= 1U << k;
+}
+
+void buddy_remove(buddy_block_t *b, int k)
+{
+    if (b->bk != NULL)
+        b->bk->fd = b->fd;
+    else
+        buddy_lists[k] = b->fd;
+    if (b->fd != NULL)
+        b->fd->bk = b->bk;
+    if (buddy_lists[k] == NULL)
+        buddy_map &= ~(1U << k);
+}
+
+void *buddy_malloc(size_t n)
+{
+    size_t need = n + FS_HDR;
+    int order = BUDDY_MIN;
+    while ((1UL << order) < need)
+        order++;
+
+    // 不小于 order 的第一个非空链表
+    uint32_t avail = buddy_map & (~0U << order);
+    if (avail == 0)
+    {
+        buddy_block_t *a = fs_map_arena();
+        if (a == NULL)
+            return NULL;
+        buddy_push(a, BUDDY_MAX);
+        avail = buddy_map & (~0U << order);
+    }
+    int k = __builtin_ctz(avail);
+    buddy_block_t *b = buddy_lists[k];
+    buddy_remove(b, k);
+
+    // 逐级切分，后一半放回低一阶的链表
+    while (k > order)
+    {
+        k--;
+        buddy_push((buddy_block_t *)((char *)b + (1UL << k)), k);
+    }
+    b->tag = ((size_t)order << 4) | FS_INUSE;
+    return (char *)b + FS_HDR;
+}
+
+void buddy_free(void *p)
+{
+    buddy_block_t *b = (buddy_block_t *)((char *)p - FS_HDR);
+    int k = buddy_order(b);
+    int start = k;
+    uintptr_t base = (uintptr_t)b & ~(FS_ARENA - 1);
+    uintptr_t off = (uintptr_t)b - base;
+    while (k < BUDDY_MAX)
+    {
+        buddy_block_t *buddy = (buddy_block_t *)(base + (((uintptr_t)b - base) ^ (1UL << k)));
+        if ((buddy->tag & FS_INUSE) || buddy_order(buddy) != k)
+            break;
+        buddy_remove(buddy, k);
+        if (buddy < b)
+            b = buddy;
+        k++;
+    }
+    buddy_push(b, k);
+
+    // 不小于 2^BUDDY_TRIM 的空闲块已经还给过内核，可能被写过的只有
+    // 合并到 2^BUDDY_TRIM 那一级时（或者本块原来就更大时）包含本块的那个块
+    if (k >= BUDDY_TRIM)
+    {
+        int t = start > BUDDY_TRIM ? start : BUDDY_TRIM;
+        char *dirty = (char *)(base + (off & ~((1UL << t) - 1)));
+        fs_release(dirty + sizeof(buddy_block_t), (1UL << t) - sizeof(buddy_block_t));
+    }
+}
+
+size_t buddy_usable(void *p)
+{
+    return (1UL << (fs_tag(p) >> 4)) - FS_HDR;
+}
+
+#endif // __buddy_h__
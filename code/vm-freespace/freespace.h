@@ -0,0 +1,224 @@
+#ifndef __freespace_h__
+#define __freespace_h__
+
+// 用户态内存分配器：fs_malloc / fs_free / fs_realloc / fs_calloc / fs_memalign
+// 后端在编译时选择：
+//   默认      - segfit.h：按大小分级的分离空闲链表 + 边界标记（合并相邻空闲块）+ 切分
+//   FS_BUDDY  - buddy.h：二进制伙伴系统，块大小为 2 的幂，释放时与伙伴逐级合并
+// 两个后端都从 mmap 得到的 64MB 区域（arena）中分配，超过 FS_BIG 的请求直接 mmap。
+// 所有操作由一把全局锁保护。
+//
+// 每个返回给用户的指针前面紧挨着一个 8 字节的标记字（tag），低 4 位是标志：
+//   FS_INUSE    - 块已分配
+//   FS_PREV     - 前一个块已分配（只有 segfit 使用）
+//   FS_MMAPPED  - 直接 mmap 的大块，tag 前面的 8 字节是映射长度
+//   FS_ALIGNED  - fs_memalign 返回的对齐指针，tag >> 4 是它到原始块的偏移
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/mman.h>
+
+#define FS_INUSE   1UL
+#define FS_PREV    2UL
+#define FS_MMAPPED 4UL
+#define FS_ALIGNED 8UL
+#define FS_FLAGS   15UL
+
+#define FS_HDR       16                    // 块头大小，同时保证 16 字节对齐
+#define FS_ARENA_LOG 26
+#define FS_ARENA     (1UL << FS_ARENA_LOG) // 64MB
+#define FS_BIG       (256UL * 1024)        // 超过它就直接 mmap
+#define FS_TRIM      (1UL << 20)           // 合并后不小于它的空闲块把物理页还给内核
+#define FS_MAX       (SIZE_MAX - FS_HDR - 4095) // 能申请的最大字节数，再大算长度时就会溢出
+
+#define fs_tag(p) (((size_t *)(p))[-1])
+
+pthread_mutex_t fs_lock = PTHREAD_MUTEX_INITIALIZER;
+size_t fs_mapped = 0; // 当前从内核映射的字节数
+
+// 映射一个按 FS_ARENA 对齐的 arena（伙伴系统靠对齐由地址算出伙伴）
+void *fs_map_arena()
+{
+    char *raw = mmap(NULL, 2 * FS_ARENA, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (raw == MAP_FAILED)
+        return NULL;
+    char *a = (char *)(((uintptr_t)raw + FS_ARENA - 1) & ~(FS_ARENA - 1));
+    if (a > raw)
+        munmap(raw, a - raw);
+    if (a + FS_ARENA < raw + 2 * FS_ARENA)
+        munmap(a + FS_ARENA, raw + 2 * FS_ARENA - (a + FS_ARENA));
+    fs_mapped += FS_ARENA;
+    return a;
+}
+
+// 把 [start, start + len) 内的整页用 MADV_DONTNEED 还给内核，再次使用时由缺页重新分配清零的页，
+// 地址不变。后端只对合并后不小于 FS_TRIM 的空闲块调用它，并且只传入之前可能被写过的那部分，
+// 已经释放过的大块不再重复 madvise，小块的释放大多不含整页，不会产生系统调用。
+void fs_release(void *start, size_t len)
+{
+    uintptr_t lo = ((uintptr_t)start + 4095) & ~4095UL;
+    uintptr_t hi = ((uintptr_t)start + len) & ~4095UL;
+    if (hi > lo)
+        madvise((void *)lo, hi - lo, MADV_DONTNEED);
+}
+
+void *fs_big_alloc(size_t n)
+{
+    size_t len = (n + FS_HDR + 4095) & ~4095UL;
+    char *base = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (base == MAP_FAILED)
+        return NULL;
+    ((size_t *)base)[0] = len;
+    ((size_t *)base)[1] = FS_MMAPPED | FS_INUSE;
+    fs_mapped += len;
+    return base + FS_HDR;
+}
+
+void fs_big_free(void *p)
+{
+    char *base = (char *)p - FS_HDR;
+    size_t len = ((size_t *)base)[0];
+    fs_mapped -= len;
+    munmap(base, len);
+}
+
+#ifdef FS_BUDDY
+#include "buddy.h"
+#define fs_backend_name     "buddy"
+#define fs_backend_malloc   buddy_malloc
+#define fs_backend_free     buddy_free
+#define fs_backend_usable   buddy_usable
+#else
+#include "segfit.h"
+#define fs_backend_name     "segfit"
+#define fs_backend_malloc   seg_malloc
+#define fs_backend_free     seg_free
+#define fs_backend_usable   seg_usable
+#endif
+
+// ---------------- 公共接口 ----------------
+//
+// 与 libc 一样，返回 NULL 时把 errno 设为 ENOMEM（fs_memalign 的对齐不合法时为 EINVAL）
+
+void *fs_malloc(size_t n)
+{
+    if (n > FS_MAX)
+    {
+        errno = ENOMEM;
+        return NULL;
+    }
+    if (n == 0)
+        n = 1;
+    void *p;
+    pthread_mutex_lock(&fs_lock);
+    if (n > FS_BIG)
+        p = fs_big_alloc(n);
+    else
+        p = fs_backend_malloc(n);
+    pthread_mutex_unlock(&fs_lock);
+    if (p == NULL)
+        errno = ENOMEM;
+    return p;
+}
+
+void fs_free(void *p)
+{
+    if (p == NULL)
+        return;
+    size_t tag = fs_tag(p);
+    if (tag & FS_ALIGNED)
+    {
+        p = (char *)p - (tag >> 4);
+        tag = fs_tag(p);
+    }
+    pthread_mutex_lock(&fs_lock);
+    if (tag & FS_MMAPPED)
+        fs_big_free(p);
+    else
+        fs_backend_free(p);
+    pthread_mutex_unlock(&fs_lock);
+}
+
+// 用户可用的字节数（可能大于申请的大小）
+size_t fs_usable(void *p)
+{
+    if (p == NULL)
+        return 0;
+    size_t tag = fs_tag(p);
+    size_t off = 0;
+    if (tag & FS_ALIGNED)
+    {
+        off = tag >> 4;
+        p = (char *)p - off;
+        tag = fs_tag(p);
+    }
+    if (tag & FS_MMAPPED)
+        return ((size_t *)p)[-2] - FS_HDR - off;
+    return fs_backend_usable(p) - off;
+}
+
+void *fs_calloc(size_t n, size_t size)
+{
+    if (size != 0 && n > SIZE_MAX / size)
+    {
+        errno = ENOMEM;
+        return NULL;
+    }
+    void *p = fs_malloc(n * size);
+    if (p != NULL)
+        memset(p, 0, n * size);
+    return p;
+}
+
+void *fs_realloc(void *p, size_t n)
+{
+    if (p == NULL)
+        return fs_malloc(n);
+    if (n == 0)
+    {
+        fs_free(p);
+        return NULL;
+    }
+    size_t have = fs_usable(p);
+    if (n <= have && n >= have / 2)
+        return p;
+    void *q = fs_malloc(n);
+    if (q != NULL)
+    {
+        memcpy(q, p, n < have ? n : have);
+        fs_free(p);
+    }
+    return q;
+}
+
+// 多申请 align 字节，在块内找一个对齐的位置，并在它前面写一个记录偏移的 tag
+void *fs_memalign(size_t align, size_t n)
+{
+    if (align <= FS_HDR)
+        return fs_malloc(n);
+    if ((align & (align - 1)) != 0)
+    {
+        errno = EINVAL;
+        return NULL;
+    }
+    if (align > FS_MAX - FS_HDR || n > FS_MAX - FS_HDR - align)
+    {
+        errno = ENOMEM;
+        return NULL;
+    }
+    char *p = fs_malloc(n + align + FS_HDR);
+    if (p == NULL)
+        return NULL;
+    if (((uintptr_t)p & (align - 1)) == 0)
+        return p;
+    char *a = (char *)(((uintptr_t)p + FS_HDR + align - 1) & ~(uintptr_t)(align - 1));
+    fs_tag(a) = ((size_t)(a - p) << 4) | FS_ALIGNED;
+    return a;
+}
+
+#endif // __freespace_h__
@@ -0,0 +1,265 @@
+// malloc/free 基准测试，本身只调用标准的 malloc/free，
+// 直接运行测的是 glibc，配合 LD_PRELOAD 测 shim.c 编译出的分配器：
+//   ./mallocbench
+//   LD_PRELOAD=./libsegfit.so ./mallocbench
+//   LD_PRELOAD=./libbuddy.so ./mallocbench
+//
+// 两种负载：
+//   random   - 维持 slots 个活跃对象，每次操作随机选一个释放并换成新大小的对象。
+//              大小 90% 在 16~256 字节，9% 在 256B~4KB，1% 在 4KB~64KB。
+//              稳定后随机释放 90% 的对象，再看 RSS：空闲块夹在存活对象之间还不回去，
+//              这就是外部碎片。
+//   prodcons - -t 对线程，每对中生产者分配 64B~2KB 的消息放进环形队列，消费者取出后释放，
+//              每次 free 都发生在另一个线程里。-r 轮，每轮换一批新线程。
+//              第一个生产者每 64K 条消息采样一次 RSS，报告峰值；
+//              结束时（队列已空）的 RSS 是分配器留着没还给内核的内存。
+//
+// 碎片率 = (RSS - 开始时的 RSS) / 存活对象的申请字节数，1.0 表示没有任何浪费。
+// 每个对象的每一页都写一遍，RSS 反映真正用到的内存。
+//
+// To compile: make
+// To run:     make compare
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sched.h>
+#include <dlfcn.h>
+#include <pthread.h>
+
+#include "common.h"
+#include "common_threads.h"
+#include "rng.h"
+
+#define MB (1024.0 * 1024.0)
+
+double rss_mb()
+{
+    long pages = 0, resident = 0;
+    FILE *fp = fopen("/proc/self/statm", "r");
+    assert(fp != NULL);
+    assert(fscanf(fp, "%ld %ld", &pages, &resident) == 2);
+    fclose(fp);
+    return resident * (double)sysconf(_SC_PAGESIZE) / MB;
+}
+
+// 写对象的每一页，让它真正占用物理内存
+void touch(char *p, size_t n)
+{
+    size_t i;
+    for (i = 0; i < n; i += 4096)
+        p[i] = (char)i;
+    p[n - 1] = 1;
+}
+
+size_t random_size(rng_t *r)
+{
+    uint64_t x = rng_bounded(r, 100);
+    if (x < 90)
+        return 16 + rng_bounded(r, 241);
+    if (x < 99)
+        return 256 + rng_bounded(r, 3841);
+    return 4096 + rng_bounded(r, 61441);
+}
+
+void report(const char *name, const char *phase, double ops_per_sec, double base, double live_mb)
+{
+    double rss = rss_mb() - base;
+    printf("%-8s %-10s %12.0f %10.1f %10.1f %8.2f\n", name, phase, ops_per_sec, rss, live_mb,
+           live_mb > 0 ? rss / live_mb : 0);
+}
+
+// ---------------- random ----------------
+
+void run_random(long slots, long ops)
+{
+    rng_t r;
+    rng_seed(&r, 42);
+    char **obj = calloc(slots, sizeof(char *));
+    size_t *size = calloc(slots, sizeof(size_t));
+    assert(obj != NULL && size != NULL);
+    double base = rss_mb();
+    size_t live = 0;
+    long i;
+
+    for (i = 0; i < slots; i++)
+    {
+        size[i] = random_size(&r);
+        obj[i] = malloc(size[i]);
+        assert(obj[i] != NULL);
+        touch(obj[i], size[i]);
+        live += size[i];
+    }
+
+    double t = GetTime();
+    for (i = 0; i < ops; i++)
+    {
+        long k = rng_bounded(&r, slots);
+        free(obj[k]);
+        live -= size[k];
+        size[k] = random_size(&r);
+        obj[k] = malloc(size[k]);
+        assert(obj[k] != NULL);
+        touch(obj[k], size[k]);
+        live += size[k];
+    }
+    t = GetTime() - t;
+    report("random", "steady", ops / t, base, live / MB);
+
+    // 释放 90% 的对象，存活的对象分散在整个堆里
+    for (i = 0; i < slots; i++)
+        if (rng_bounded(&r, 10) != 0)
+        {
+            free(obj[i]);
+            live -= size[i];
+            obj[i] = NULL;
+        }
+    report("random", "after-free", 0, base, live / MB);
+
+    for (i = 0; i < slots; i++)
+        free(obj[i]);
+    free(obj);
+    free(size);
+}
+
+// ---------------- prodcons ----------------
+
+#define RING 4096
+
+// 一对生产者/消费者共用的环形队列
+typedef struct
+{
+    char *ring[RING];
+    size_t size[RING];
+    volatile long head, tail; // 生产者写 head，消费者写 tail
+    long ops;
+    uint64_t seed;
+    int sampler; // 每轮第一对的生产者负责采样 RSS
+} pair_t;
+
+long live_bytes; // 所有队列里消息的总字节数
+double peak_rss, peak_live;
+
+void *producer(void *arg)
+{
+    pair_t *q = arg;
+    rng_t r;
+    rng_seed(&r, q->seed);
+    long i;
+    for (i = 0; i < q->ops; i++)
+    {
+        while (q->head - __atomic_load_n(&q->tail, __ATOMIC_ACQUIRE) == RING)
+            sched_yield();
+        size_t n = 64 + rng_bounded(&r, 1985);
+        char *p = malloc(n);
+        assert(p != NULL);
+        touch(p, n);
+        q->ring[q->head % RING] = p;
+        q->size[q->head % RING] = n;
+        long live = __atomic_add_fetch(&live_bytes, n, __ATOMIC_RELAXED);
+        __atomic_store_n(&q->head, q->head + 1, __ATOMIC_RELEASE);
+        if (i % 65536 == 0 && q->sampler)
+        {
+            double rss = rss_mb();
+            if (rss > peak_rss)
+                peak_rss = rss;
+            if (live / MB > peak_live)
+                peak_live = live / MB;
+        }
+    }
+    return NULL;
+}
+
+void *consumer(void *arg)
+{
+    pair_t *q = arg;
+    long i;
+    for (i = 0; i < q->ops; i++)
+    {
+        while (__atomic_load_n(&q->head, __ATOMIC_ACQUIRE) == q->tail)
+            sched_yield();
+        free(q->ring[q->tail % RING]);
+        __atomic_sub_fetch(&live_bytes, q->size[q->tail % RING], __ATOMIC_RELAXED);
+        __atomic_store_n(&q->tail, q->tail + 1, __ATOMIC_RELEASE);
+    }
+    return NULL;
+}
+
+// 每一轮新建 pairs 对线程，总共 ops 条消息平均分给各轮各对
+void run_prodcons(long ops, int pairs, int rounds)
+{
+    pthread_t *th = calloc(2 * pairs, sizeof(pthread_t));
+    pair_t *q = calloc(pairs, sizeof(pair_t));
+    assert(th != NULL && q != NULL);
+    double base = rss_mb();
+    peak_rss = base;
+    peak_live = 0;
+    double t = GetTime();
+    int r, i;
+    for (r = 0; r < rounds; r++)
+    {
+        for (i = 0; i < pairs; i++)
+        {
+            q[i].head = q[i].tail = 0;
+            q[i].ops = ops / rounds / pairs;
+            q[i].seed = 1 + r * pairs + i;
+            q[i].sampler = i == 0;
+            Pthread_create(&th[2 * i], NULL, producer, &q[i]);
+            Pthread_create(&th[2 * i + 1], NULL, consumer, &q[i]);
+        }
+        for (i = 0; i < 2 * pairs; i++)
+            Pthread_join(th[i], NULL);
+        // 线程退出后留下的缓存与 arena 也算在峰值里
+        double rss = rss_mb();
+        if (rss > peak_rss)
+            peak_rss = rss;
+    }
+    t = GetTime() - t;
+    long done = ops / rounds / pairs * rounds * pairs;
+    printf("%-8s %-10s %12.0f %10.1f %10.1f %8.2f\n", "prodcons", "peak", done / t, peak_rss - base, peak_live,
+           peak_live > 0 ? (peak_rss - base) / peak_live : 0);
+    report("prodcons", "done", 0, base, 0);
+    free(th);
+    free(q);
+}
+
+void usage()
+{
+    fprintf(stderr, "usage: mallocbench [-s slots] [-n ops] [-p prodcons-ops] [-t pairs] [-r rounds] [-w random|prodcons|all]\n");
+    exit(1);
+}
+
+int main(int argc, char *argv[])
+{
+    long slots = 200000;
+    long ops = 5000000;
+    long pc = 5000000;
+    int pairs = 1, rounds = 1;
+    char *which = "all";
+    int opt;
+    while ((opt = getopt(argc, argv, "s:n:p:t:r:w:")) != -1)
+    {
+        switch (opt)
+        {
+        case 's': slots = atol(optarg); break;
+        case 'n': ops = atol(optarg); break;
+        case 'p': pc = atol(optarg); break;
+        case 't': pairs = atoi(optarg); break;
+        case 'r': rounds = atoi(optarg); break;
+        case 'w': which = optarg; break;
+        default:  usage();
+        }
+    }
+    assert(slots > 0 && ops > 0 && pairs > 0 && rounds > 0 && pc >= (long)pairs * rounds);
+
+    const char **name = dlsym(RTLD_DEFAULT, "fs_allocator_name");
+    printf("allocator: %s\n", name != NULL ? *name : "glibc");
+    printf("%-8s %-10s %12s %10s %10s %8s\n", "workload", "phase", "ops/sec", "rss-MB", "live-MB", "frag");
+    if (strcmp(which, "random") == 0 || strcmp(which, "all") == 0)
+        run_random(slots, ops);
+    if (strcmp(which, "prodcons") == 0 || strcmp(which, "all") == 0)
+        run_prodcons(pc, pairs, rounds);
+    return 0;
+}
@@ -0,0 +1,180 @@
+#ifndef __segfit_h__
+#define __segfit_h__
+
+// 分离适配（segregated fit）：空闲块按大小分到 SEG_CLASSES 个链表里
+//   小于 1KB：每 16 字节一级，链表里的块大小都相同
+//   1KB 以上：每个 2 的幂再分 4 级，链表内按首次适配查找
+// 在自己的级别里找不到时，用位图直接跳到下一个非空的更大级别，取第一个块并切分。
+//
+// 块布局（边界标记）：
+//   [prev_size][size | FS_INUSE | FS_PREV][用户数据 ...]
+// prev_size 只在前一个块空闲时有效（即空闲块的尾部标记），
+// FS_PREV 表示前一个块已分配，释放时据此决定能否与前一个块合并。
+// 空闲块的用户数据区存放双向链表指针 fd / bk，所以最小块为 32 字节。
+// 每个 arena 末尾有一个 16 字节、标记为已分配的哨兵块，合并不会越过 arena。
+
+typedef struct __seg_chunk_t
+{
+    size_t prev_size;
+    size_t size;
+    struct __seg_chunk_t *fd;
+    struct __seg_chunk_t *bk;
+} seg_chunk_t;
+
+#define SEG_MIN     32
+#define SEG_CLASSES 128
+
+seg_chunk_t *seg_bins[SEG_CLASSES];
+uint64_t seg_map[SEG_CLASSES / 64]; // 非空链表的位图
+
+#define seg_size(c) ((c)->size & ~FS_FLAGS)
+#define seg_at(c, off) ((seg_chunk_t *)((char *)(c) + (off)))
+
+int seg_class(size_t size)
+{
+    if (size < 1024)
+        return size >> 4;
+    int lg = 63 - __builtin_clzl(size);
+    return 64 + (lg - 10) * 4 + ((size >> (lg - 2)) & 3);
+}
+
+void seg_insert(seg_chunk_t *c)
+{
+    int k = seg_class(seg_size(c));
+    c->bk = NULL;
+    c->fd = seg_bins[k];
+    if (c->fd != NULL)
+        c->fd->bk = c;
+    seg_bins[k] = c;
+    seg_map[k / 64] |= 1UL << (k % 64);
+}
+
+void seg_unlink(seg_chunk_t *c)
+{
+    int k = seg_class(seg_size(c));
+    if (c->bk != NULL)
+        c->bk->fd = c->fd;
+    else
+        seg_bins[k] = c->fd;
+    if (c->fd != NULL)
+        c->fd->bk = c->bk;
+    if (seg_bins[k] == NULL)
+        seg_map[k / 64] &= ~(1UL << (k % 64));
+}
+
+// 大于 k 的第一个非空级别，没有返回 -1
+int seg_next_class(int k)
+{
+    int w;
+    for (w = (k + 1) / 64; w < SEG_CLASSES / 64; w++)
+    {
+        uint64_t bits = seg_map[w];
+        if (w == (k + 1) / 64)
+            bits &= ~0UL << ((k + 1) % 64);
+        if (bits != 0)
+            return w * 64 + __builtin_ctzl(bits);
+    }
+    return -1;
+}
+
+// 新 arena 整体是一个空闲块，后面跟着哨兵
+int seg_grow()
+{
+    char *a = fs_map_arena();
+    if (a == NULL)
+        return -1;
+    seg_chunk_t *c = (seg_chunk_t *)a;
+    size_t size = FS_ARENA - FS_HDR;
+    c->size = size | FS_PREV;
+    seg_chunk_t *fence = seg_at(c, size);
+    fence->prev_size = size;
+    fence->size = FS_HDR | FS_INUSE;
+    seg_insert(c);
+    return 0;
+}
+
+seg_chunk_t *seg_find(size_t need)
+{
+    int k = seg_class(need);
+    seg_chunk_t *c;
+    for (c = seg_bins[k]; c != NULL; c = c->fd)
+        if (seg_size(c) >= need)
+            return c;
+    k = seg_next_class(k);
+    return k < 0 ? NULL : seg_bins[k];
+}
+
+void *seg_malloc(size_t n)
+{
+    size_t need = ((n + 15) & ~15UL) + FS_HDR;
+    seg_chunk_t *c = seg_find(need);
+    if (c == NULL)
+    {
+        if (seg_grow() < 0)
+            return NULL;
+        c = seg_find(need);
+    }
+    seg_unlink(c);
+
+    size_t size = seg_size(c);
+    if (size - need >= SEG_MIN)
+    {
+        // 切分：后半部分成为新的空闲块
+        seg_chunk_t *rest = seg_at(c, need);
+        rest->size = (size - need) | FS_PREV;
+        seg_at(rest, size - need)->prev_size = size - need;
+        seg_insert(rest);
+        c->size = need | FS_INUSE | (c->size & FS_PREV);
+    }
+    else
+    {
+        c->size |= FS_INUSE;
+        seg_at(c, size)->size |= FS_PREV;
+    }
+    return (char *)c + FS_HDR;
+}
+
+void seg_free(void *p)
+{
+    seg_chunk_t *c = (seg_chunk_t *)((char *)p - FS_HDR);
+    size_t size = seg_size(c);
+
+    // 可能被写过的范围：本块加上小于 FS_TRIM 的空闲邻居（大的在合并成大块时已经还给内核了）
+    char *dirty_lo = (char *)c;
+    char *dirty_hi = (char *)c + size;
+
+    // 与后一个空闲块合并
+    seg_chunk_t *next = seg_at(c, size);
+    if (!(next->size & FS_INUSE))
+    {
+        seg_unlink(next);
+        if (seg_size(next) < FS_TRIM)
+            dirty_hi += seg_size(next);
+        size += seg_size(next);
+    }
+    // 与前一个空闲块合并，它的大小记录在本块的 prev_size 里
+    if (!(c->size & FS_PREV))
+    {
+        seg_chunk_t *prev = seg_at(c, -(long)c->prev_size);
+        seg_unlink(prev);
+        if (seg_size(prev) < FS_TRIM)
+            dirty_lo = (char *)prev;
+        size += seg_size(prev);
+        c = prev;
+    }
+    // 相邻的空闲块总会被合并，所以 c 前面的块一定已分配
+    c->size = size | FS_PREV;
+    next = seg_at(c, size);
+    next->prev_size = size;
+    next->size &= ~FS_PREV;
+    seg_insert(c);
+    if (size >= FS_TRIM)
+        fs_release(dirty_lo + sizeof(seg_chunk_t), dirty_hi - dirty_lo - sizeof(seg_chunk_t));
+}
+
+size_t seg_usable(void *p)
+{
+    return (fs_tag(p) & ~FS_FLAGS) - FS_HDR;
+}
+
+#endif // __segfit_h__
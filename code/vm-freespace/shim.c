@@ -0,0 +1,116 @@
+// 用 freespace.h 替换 C 库的 malloc 系列函数，编译成共享库后通过 LD_PRELOAD 使用：
+//   LD_PRELOAD=./libsegfit.so ls
+//   LD_PRELOAD=./libbuddy.so ./mallocbench
+//   LD_PRELOAD=./libtcache.so ./mallocbench
+// 后端由编译时的 -DFS_BUDDY 决定，-DFS_TCACHE 在后端之上加 tcache.h 的线程缓存，见 Makefile。
+
+#include <errno.h>
+#ifdef FS_TCACHE
+#include "tcache.h"
+#define shim_malloc   tc_malloc
+#define shim_free     tc_free
+#define shim_calloc   tc_calloc
+#define shim_realloc  tc_realloc
+#define shim_memalign tc_memalign
+#define shim_usable   tc_usable
+#define shim_name     "tcache+" fs_backend_name
+#else
+#include "freespace.h"
+#define shim_malloc   fs_malloc
+#define shim_free     fs_free
+#define shim_calloc   fs_calloc
+#define shim_realloc  fs_realloc
+#define shim_memalign fs_memalign
+#define shim_usable   fs_usable
+#define shim_name     fs_backend_name
+#endif
+
+// mallocbench 通过 dlsym 查这个符号，报告当前用的是哪个分配器
+const char *fs_allocator_name = shim_name;
+
+// fork 时持有全局锁，子进程里的锁状态才是一致的（否则可能复制到别的线程持有的锁）
+void fs_prefork()
+{
+#ifdef FS_TCACHE
+    pthread_mutex_lock(&tc_lock);
+#endif
+    pthread_mutex_lock(&fs_lock);
+}
+
+void fs_postfork()
+{
+    pthread_mutex_unlock(&fs_lock);
+#ifdef FS_TCACHE
+    pthread_mutex_unlock(&tc_lock);
+#endif
+}
+
+__attribute__((constructor)) void fs_init()
+{
+    pthread_atfork(fs_prefork, fs_postfork, fs_postfork);
+}
+
+void *malloc(size_t n)
+{
+    return shim_malloc(n);
+}
+
+void free(void *p)
+{
+    shim_free(p);
+}
+
+void *calloc(size_t n, size_t size)
+{
+    return shim_calloc(n, size);
+}
+
+void *realloc(void *p, size_t n)
+{
+    return shim_realloc(p, n);
+}
+
+void *memalign(size_t align, size_t n)
+{
+    return shim_memalign(align, n);
+}
+
+void *aligned_alloc(size_t align, size_t n)
+{
+    return shim_memalign(align, n);
+}
+
+int posix_memalign(void **out, size_t align, size_t n)
+{
+    if (align < sizeof(void *) || (align & (align - 1)) != 0)
+        return EINVAL;
+    int saved = errno; // posix_memalign 通过返回值报告错误，不改 errno
+    void *p = shim_memalign(align, n);
+    if (p == NULL)
+    {
+        errno = saved;
+        return ENOMEM;
+    }
+    *out = p;
+    return 0;
+}
+
+void *valloc(size_t n)
+{
+    return shim_memalign(4096, n);
+}
+
+void *pvalloc(size_t n)
+{
+    if (n > SIZE_MAX - 4095)
+    {
+        errno = ENOMEM;
+        return NULL;
+    }
+    return shim_memalign(4096, (n + 4095) & ~4095UL);
+}
+
+size_t malloc_usable_size(void *p)
+{
+    return shim_usable(p);
+}
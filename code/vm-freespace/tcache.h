@@ -0,0 +1,379 @@
+#ifndef __tcache_h__
+#define __tcache_h__
+
+// freespace.h 之上的线程缓存前端：tc_malloc / tc_free / tc_calloc / tc_realloc / tc_memalign
+// 不超过 TC_MAX 的请求由前端处理，更大的和对齐要求超过 16 字节的交给 freespace.h。
+//
+//   - span：64KB 对齐的一段内存，只装一个大小级别的对象，开头是 span 头部。
+//     每个 span 属于一个线程缓存，对象的地址按 64KB 对齐向下取整就是它的 span。
+//   - 弹匣（magazine）：每个线程每个级别一个指针数组，申请和本线程的释放只在数组上压栈出栈，
+//     不加锁、不用原子操作。空了从本线程的 span 里一次装 TC_BATCH 个，
+//     满了把最早放进去的 TC_BATCH 个还给各自的 span。
+//   - 远程释放队列：线程 B 释放线程 A 的 span 里的对象时，用 CAS 把它压进 A 的远程队列，
+//     A 的弹匣空了时一次取走整个队列，把对象还给自己的 span。对象总是回到所属的线程，
+//     一个线程申请、另一个线程释放的模式下，内存不会在释放方堆积。
+//   - 线程退出时它的缓存（连同 span 和远程队列）被挂到孤儿链表上，下一个新线程直接接管，
+//     缓存的数量不超过同时存在的线程数。
+//   - 对象全部空闲的 span 放回全局 span 池（加锁），任何线程的任何级别都可以再用；
+//     池里已有 TC_KEEP 个 span 时，再放回的 span 先把物理页还给内核。
+//
+// span 从 fs_map_arena 得到的 64MB arena 中切出，arena 记录在按 64MB 粒度的位图里，
+// tc_free 据此判断指针来自前端还是后端。
+
+#include "freespace.h"
+
+#define TC_SPAN_LOG 16
+#define TC_SPAN     (1UL << TC_SPAN_LOG)
+#define TC_HDR      128                  // span 头部，对象从这里开始
+#define TC_MAX      8192
+#define TC_CLASSES  36
+#define TC_MAG      64
+#define TC_BATCH    32
+#define TC_KEEP     64                   // span 池里保留这么多个不还物理页的 span，避免反复缺页
+
+typedef struct __tc_obj_t
+{
+    struct __tc_obj_t *next;
+} tc_obj_t;
+
+struct __tc_cache_t;
+
+typedef struct __tc_span_t
+{
+    struct __tc_cache_t *owner;
+    int cls;
+    int size;
+    tc_obj_t *free;                   // 还回来的对象，只有所属线程访问
+    char *bump;                       // 还没切出去的部分
+    char *end;
+    long inuse;                       // 在弹匣里或者被用户持有的对象数
+    int listed;                       // 是否在所属线程的 partial 链表上
+    struct __tc_span_t *next;
+    struct __tc_span_t *prev;
+} tc_span_t;
+
+typedef struct
+{
+    int n;
+    void *objs[TC_MAG];
+} tc_mag_t;
+
+typedef struct __tc_cache_t
+{
+    tc_obj_t *remote;                 // 远程释放队列，其他线程 CAS 压栈
+    char pad[56];                     // 远程队列独占一个缓存行
+    tc_mag_t mags[TC_CLASSES];
+    tc_span_t *partial[TC_CLASSES];   // 还有空闲对象的 span
+    struct __tc_cache_t *next_orphan;
+} tc_cache_t;
+
+int tc_sizes[TC_CLASSES];
+
+pthread_mutex_t tc_lock = PTHREAD_MUTEX_INITIALIZER; // 保护 span 池、arena 和孤儿链表
+tc_span_t *tc_free_spans;
+long tc_nfree;
+char *tc_arena_next, *tc_arena_end;
+uint64_t tc_arena_map[1 << 16];       // 48 位地址空间，每位对应一个 64MB arena
+tc_cache_t *tc_orphans;
+pthread_key_t tc_key;
+pthread_once_t tc_once = PTHREAD_ONCE_INIT;
+__thread tc_cache_t *tc_self __attribute__((tls_model("initial-exec")));
+
+// 256 字节以内每 16 字节一级，之后每个 2 的幂分 4 级
+int tc_class(size_t n)
+{
+    if (n <= 256)
+        return n == 0 ? 0 : (n + 15) / 16 - 1;
+    int lg = 63 - __builtin_clzl(n - 1);
+    return 16 + (lg - 8) * 4 + (int)((n - 1 - (1UL << lg)) >> (lg - 2));
+}
+
+int tc_is_ours(void *p)
+{
+    uintptr_t a = (uintptr_t)p >> FS_ARENA_LOG;
+    return a < (1UL << 22) && (tc_arena_map[a / 64] >> (a % 64) & 1);
+}
+
+#define tc_span_of(p) ((tc_span_t *)((uintptr_t)(p) & ~(TC_SPAN - 1)))
+
+void tc_detach(void *arg)
+{
+    tc_cache_t *c = arg;
+    tc_self = NULL;
+    pthread_mutex_lock(&tc_lock);
+    c->next_orphan = tc_orphans;
+    tc_orphans = c;
+    pthread_mutex_unlock(&tc_lock);
+}
+
+void tc_init()
+{
+    int c;
+    for (c = 0; c < 16; c++)
+        tc_sizes[c] = (c + 1) * 16;
+    for (c = 16; c < TC_CLASSES; c++)
+    {
+        int lg = 8 + (c - 16) / 4;
+        tc_sizes[c] = (1 << lg) + ((c - 16) % 4 + 1) * (1 << (lg - 2));
+    }
+    pthread_key_create(&tc_key, tc_detach);
+}
+
+// 当前线程的缓存：优先接管已退出线程留下的缓存
+tc_cache_t *tc_attach()
+{
+    pthread_once(&tc_once, tc_init);
+    pthread_mutex_lock(&tc_lock);
+    tc_cache_t *c = tc_orphans;
+    if (c != NULL)
+        tc_orphans = c->next_orphan;
+    pthread_mutex_unlock(&tc_lock);
+    if (c == NULL)
+    {
+        c = mmap(NULL, sizeof(tc_cache_t), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (c == MAP_FAILED)
+            return NULL;
+    }
+    tc_self = c;
+    pthread_setspecific(tc_key, c);
+    return c;
+}
+
+tc_span_t *tc_span_alloc()
+{
+    pthread_mutex_lock(&tc_lock);
+    tc_span_t *s = tc_free_spans;
+    if (s != NULL)
+    {
+        tc_free_spans = s->next;
+        tc_nfree--;
+    }
+    else
+    {
+        if (tc_arena_next == tc_arena_end)
+        {
+            pthread_mutex_lock(&fs_lock);
+            char *a = fs_map_arena();
+            pthread_mutex_unlock(&fs_lock);
+            if (a == NULL)
+            {
+                pthread_mutex_unlock(&tc_lock);
+                return NULL;
+            }
+            uintptr_t k = (uintptr_t)a >> FS_ARENA_LOG;
+            tc_arena_map[k / 64] |= 1UL << (k % 64);
+            tc_arena_next = a;
+            tc_arena_end = a + FS_ARENA;
+        }
+        s = (tc_span_t *)tc_arena_next;
+        tc_arena_next += TC_SPAN;
+    }
+    pthread_mutex_unlock(&tc_lock);
+    return s;
+}
+
+void tc_list_add(tc_cache_t *c, tc_span_t *s)
+{
+    s->prev = NULL;
+    s->next = c->partial[s->cls];
+    if (s->next != NULL)
+        s->next->prev = s;
+    c->partial[s->cls] = s;
+    s->listed = 1;
+}
+
+void tc_list_remove(tc_cache_t *c, tc_span_t *s)
+{
+    if (s->prev != NULL)
+        s->prev->next = s->next;
+    else
+        c->partial[s->cls] = s->next;
+    if (s->next != NULL)
+        s->next->prev = s->prev;
+    s->listed = 0;
+}
+
+// 所属线程把对象还给 span；span 全空并且不是当前分配用的那个时，整个还给 span 池
+void tc_span_put(tc_cache_t *c, void *p)
+{
+    tc_span_t *s = tc_span_of(p);
+    tc_obj_t *o = p;
+    o->next = s->free;
+    s->free = o;
+    s->inuse--;
+    if (!s->listed)
+        tc_list_add(c, s);
+    if (s->inuse == 0 && c->partial[s->cls] != s)
+    {
+        tc_list_remove(c, s);
+        pthread_mutex_lock(&tc_lock);
+        if (tc_nfree >= TC_KEEP)
+            fs_release((char *)s + TC_HDR, TC_SPAN - TC_HDR);
+        s->next = tc_free_spans;
+        tc_free_spans = s;
+        tc_nfree++;
+        pthread_mutex_unlock(&tc_lock);
+    }
+}
+
+void tc_drain_remote(tc_cache_t *c)
+{
+    if (__atomic_load_n(&c->remote, __ATOMIC_RELAXED) == NULL)
+        return;
+    tc_obj_t *o = __atomic_exchange_n(&c->remote, NULL, __ATOMIC_ACQUIRE);
+    while (o != NULL)
+    {
+        tc_obj_t *next = o->next;
+        tc_span_put(c, o);
+        o = next;
+    }
+}
+
+// 从本线程的 span 里装满 TC_BATCH 个对象；返回 -1 表示内存耗尽
+int tc_refill(tc_cache_t *c, int cls)
+{
+    tc_mag_t *m = &c->mags[cls];
+    while (m->n < TC_BATCH)
+    {
+        tc_span_t *s = c->partial[cls];
+        if (s == NULL)
+        {
+            s = tc_span_alloc();
+            if (s == NULL)
+                return m->n > 0 ? 0 : -1;
+            s->owner = c;
+            s->cls = cls;
+            s->size = tc_sizes[cls];
+            s->free = NULL;
+            s->bump = (char *)s + TC_HDR;
+            s->end = (char *)s + TC_SPAN - (TC_SPAN - TC_HDR) % s->size;
+            s->inuse = 0;
+            tc_list_add(c, s);
+        }
+        void *p;
+        if (s->free != NULL)
+        {
+            p = s->free;
+            s->free = s->free->next;
+        }
+        else if (s->bump < s->end)
+        {
+            p = s->bump;
+            s->bump += s->size;
+        }
+        else
+        {
+            tc_list_remove(c, s); // 满了，等有对象还回来再挂上
+            continue;
+        }
+        s->inuse++;
+        m->objs[m->n++] = p;
+    }
+    return 0;
+}
+
+void *tc_malloc(size_t n)
+{
+    if (n > TC_MAX)
+        return fs_malloc(n);
+    tc_cache_t *c = tc_self;
+    if (c == NULL && (c = tc_attach()) == NULL)
+        return fs_malloc(n);
+    int cls = tc_class(n);
+    tc_mag_t *m = &c->mags[cls];
+    if (m->n == 0)
+    {
+        tc_drain_remote(c);
+        if (tc_refill(c, cls) < 0)
+        {
+            errno = ENOMEM;
+            return NULL;
+        }
+    }
+    return m->objs[--m->n];
+}
+
+void tc_free(void *p)
+{
+    if (p == NULL)
+        return;
+    if (!tc_is_ours(p))
+    {
+        fs_free(p);
+        return;
+    }
+    tc_span_t *s = tc_span_of(p);
+    tc_cache_t *c = tc_self;
+    if (s->owner != c)
+    {
+        // 远程释放：压进所属线程的队列
+        tc_cache_t *owner = s->owner;
+        tc_obj_t *o = p;
+        o->next = __atomic_load_n(&owner->remote, __ATOMIC_RELAXED);
+        while (!__atomic_compare_exchange_n(&owner->remote, &o->next, o, 1, __ATOMIC_RELEASE, __ATOMIC_RELAXED))
+            ;
+        return;
+    }
+    tc_mag_t *m = &c->mags[s->cls];
+    if (m->n == TC_MAG)
+    {
+        // 把最早放进来的一半还给 span，最近释放的（还在缓存里的）留下
+        int i;
+        for (i = 0; i < TC_BATCH; i++)
+            tc_span_put(c, m->objs[i]);
+        memmove(m->objs, m->objs + TC_BATCH, (TC_MAG - TC_BATCH) * sizeof(void *));
+        m->n -= TC_BATCH;
+    }
+    m->objs[m->n++] = p;
+}
+
+size_t tc_usable(void *p)
+{
+    if (p != NULL && tc_is_ours(p))
+        return tc_span_of(p)->size;
+    return fs_usable(p);
+}
+
+void *tc_calloc(size_t n, size_t size)
+{
+    if (size != 0 && n > SIZE_MAX / size)
+    {
+        errno = ENOMEM;
+        return NULL;
+    }
+    void *p = tc_malloc(n * size);
+    if (p != NULL)
+        memset(p, 0, n * size);
+    return p;
+}
+
+void *tc_realloc(void *p, size_t n)
+{
+    if (p == NULL)
+        return tc_malloc(n);
+    if (n == 0)
+    {
+        tc_free(p);
+        return NULL;
+    }
+    size_t have = tc_usable(p);
+    if (n <= have && n >= have / 2)
+        return p;
+    void *q = tc_malloc(n);
+    if (q != NULL)
+    {
+        memcpy(q, p, n < have ? n : have);
+        tc_free(p);
+    }
+    return q;
+}
+
+// 对象只保证 16 字节对齐，更大的对齐交给后端
+void *tc_memalign(size_t align, size_t n)
+{
+    if (align <= FS_HDR)
+        return tc_malloc(n);
+    return fs_memalign(align, n);
+}
+
+#endif // __tcache_h__
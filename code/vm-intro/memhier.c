@@ -0,0 +1,537 @@
+// 存储层次测试：延迟、带宽和伪共享（mem.c 的延伸，测量 L1/L2/L3/DRAM 各级的拐点）
+//
+//   -t latency    随机指针追逐：工作集从 4KB 到 -s 指定的上限（默认 4GB，不超过物理内存的一半），
+//                 每个缓存行存着下一个要访问的缓存行的地址，顺序是 rng_cycle 生成的随机单环，
+//                 硬件预取猜不到下一个地址，每次加载都要等上一次完成，测到的就是该层次的访问延迟。
+//   -t bandwidth  流式 read / write / copy，标量、SSE2、AVX2 三种实现（AVX2 运行时检测），
+//                 -T 个线程各自绑定一个 CPU、各用自己的缓冲区，报告总带宽；
+//                 每线程工作集从 16KB 扫到 -s，工作集能放进哪一级缓存，带宽就是那一级的。
+//   -t falseshare -T 个线程各自反复递增自己的计数器，计数器之间相隔 8~128 字节：
+//                 间隔小于缓存行时，几个计数器落在同一行里，缓存行在核之间来回传递。
+//
+// 延迟和带宽测试的内存用 MADV_HUGEPAGE 映射，避免大工作集时测到的主要是 TLB 未命中（-P 改用 4KB 页）。
+// 输出中比前一行慢 30% 以上的点标为拐点，开头打印 sysfs 报告的各级缓存大小作对照。
+//
+// To compile: make
+// To run:     ./memhier -t latency -s 1G && ./memhier -t bandwidth -T 1,2 && ./memhier -t falseshare -T 2
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#ifdef __x86_64__
+#include <immintrin.h>
+#endif
+
+#include "common_threads.h"
+#include "cycles.h"
+#include "rng.h"
+
+#define LINE      64
+#define HUGE_PAGE (2 * 1024 * 1024)
+
+int use_thp = 1;
+
+// 按大页对齐的缓冲区；raw/len 是实际的映射，释放时要用
+typedef struct
+{
+    char *p;
+    char *raw;
+    size_t len;
+} buffer_t;
+
+buffer_t map_buffer(size_t bytes)
+{
+    buffer_t b;
+    bytes = (bytes + HUGE_PAGE - 1) / HUGE_PAGE * HUGE_PAGE;
+    b.len = bytes + HUGE_PAGE;
+    b.raw = mmap(NULL, b.len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    assert(b.raw != MAP_FAILED);
+    b.p = (char *)(((uintptr_t)b.raw + HUGE_PAGE - 1) & ~(uintptr_t)(HUGE_PAGE - 1));
+    madvise(b.p, bytes, use_thp ? MADV_HUGEPAGE : MADV_NOHUGEPAGE);
+    memset(b.p, 1, bytes); // 预先触发缺页
+    return b;
+}
+
+void unmap_buffer(buffer_t *b)
+{
+    assert(munmap(b->raw, b->len) == 0);
+}
+
+// 形如 64K、4M、1G 的大小
+size_t parse_size(const char *s)
+{
+    char *end;
+    double v = strtod(s, &end);
+    switch (*end)
+    {
+    case 'k': case 'K': v *= 1024; break;
+    case 'm': case 'M': v *= 1024 * 1024; break;
+    case 'g': case 'G': v *= 1024.0 * 1024 * 1024; break;
+    }
+    return (size_t)v;
+}
+
+void print_size(size_t bytes, char *buf)
+{
+    if (bytes >= (1UL << 30))
+        sprintf(buf, "%.4gG", bytes / (double)(1UL << 30));
+    else if (bytes >= (1UL << 20))
+        sprintf(buf, "%.4gM", bytes / (double)(1UL << 20));
+    else
+        sprintf(buf, "%.4gK", bytes / 1024.0);
+}
+
+// sysfs 中 cpu0 的各级缓存
+void print_caches()
+{
+    int i;
+    printf("caches:");
+    for (i = 0; i < 8; i++)
+    {
+        char path[128], level[16], type[32], size[32];
+        FILE *fp;
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu0/cache/index%d/level", i);
+        if ((fp = fopen(path, "r")) == NULL)
+            break;
+        assert(fscanf(fp, "%15s", level) == 1);
+        fclose(fp);
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu0/cache/index%d/type", i);
+        if ((fp = fopen(path, "r")) == NULL || fscanf(fp, "%31s", type) != 1)
+            strcpy(type, "?");
+        if (fp != NULL)
+            fclose(fp);
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu0/cache/index%d/size", i);
+        if ((fp = fopen(path, "r")) == NULL || fscanf(fp, "%31s", size) != 1)
+            strcpy(size, "?");
+        if (fp != NULL)
+            fclose(fp);
+        printf("  L%s-%s %s", level, type[0] == 'I' ? "i" : type[0] == 'D' ? "d" : "", size);
+    }
+    printf("\n");
+}
+
+// 大小序列：每个 2 的幂之间再取一个 1.5 倍的点
+size_t next_size(size_t s)
+{
+    size_t pow2 = 1UL << (63 - __builtin_clzl(s));
+    return s == pow2 ? s + s / 2 : pow2 * 2;
+}
+
+// ---------------- latency ----------------
+
+// 前 n 个缓存行串成一个随机单环（rng_cycle 给出每一行的后继），返回环的起点
+void **build_chain(char *mem, size_t n, uint32_t *next, rng_t *r)
+{
+    size_t i;
+    rng_cycle(r, next, n);
+    for (i = 0; i < n; i++)
+        *(void **)(mem + i * LINE) = mem + (size_t)next[i] * LINE;
+    return (void **)mem;
+}
+
+void run_latency(size_t max, long accesses)
+{
+    buffer_t chain = map_buffer(max);
+    char *mem = chain.p;
+    uint32_t *next = malloc(max / LINE * sizeof(uint32_t));
+    assert(next != NULL);
+    rng_t r;
+    rng_seed(&r, 1);
+
+    printf("%10s %12s %12s\n", "size", "ns/load", "cycles/load");
+    double last = 0;
+    size_t size;
+    for (size = 4096; size <= max; size = next_size(size))
+    {
+        void **p = build_chain(mem, size / LINE, next, &r);
+        long n = accesses / 8 * 8, i;
+        for (i = 0; i < (long)(size / LINE); i++) // 预热：走一整圈
+            p = *p;
+        uint64_t start = cycles_now();
+        for (i = 0; i < n; i += 8)
+        {
+            p = *p; p = *p; p = *p; p = *p;
+            p = *p; p = *p; p = *p; p = *p;
+        }
+        uint64_t end = cycles_now();
+        __asm__ __volatile__("" : : "r"(p));
+        double ns = cycles_to_ns(end - start) / n;
+        char buf[32];
+        print_size(size, buf);
+        printf("%10s %12.2f %12.1f%s\n", buf, ns, (double)(end - start) / n,
+               last > 0 && ns > last * 1.3 ? "   <- knee" : "");
+        last = ns;
+    }
+    free(next);
+    unmap_buffer(&chain);
+}
+
+// ---------------- bandwidth ----------------
+
+typedef double (*kernel_t)(char *a, char *b, size_t bytes);
+
+// 标量版本关掉自动向量化，否则编译器会把它变成 SIMD
+__attribute__((optimize("no-tree-vectorize"))) double read_scalar(char *a, char *b, size_t bytes)
+{
+    uint64_t *p = (uint64_t *)a, s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+    size_t i, n = bytes / 8;
+    for (i = 0; i < n; i += 4)
+    {
+        s0 += p[i];
+        s1 += p[i + 1];
+        s2 += p[i + 2];
+        s3 += p[i + 3];
+    }
+    return (double)(s0 + s1 + s2 + s3);
+}
+
+__attribute__((optimize("no-tree-vectorize"))) double write_scalar(char *a, char *b, size_t bytes)
+{
+    uint64_t *p = (uint64_t *)a;
+    size_t i, n = bytes / 8;
+    for (i = 0; i < n; i++)
+        p[i] = i;
+    return 0;
+}
+
+__attribute__((optimize("no-tree-vectorize"))) double copy_scalar(char *a, char *b, size_t bytes)
+{
+    uint64_t *s = (uint64_t *)a, *d = (uint64_t *)b;
+    size_t i, n = bytes / 8;
+    for (i = 0; i < n; i++)
+        d[i] = s[i];
+    return 0;
+}
+
+#ifdef __x86_64__
+double read_sse(char *a, char *b, size_t bytes)
+{
+    __m128i s0 = _mm_setzero_si128(), s1 = s0, s2 = s0, s3 = s0;
+    size_t i;
+    for (i = 0; i < bytes; i += 64)
+    {
+        s0 = _mm_add_epi64(s0, _mm_load_si128((__m128i *)(a + i)));
+        s1 = _mm_add_epi64(s1, _mm_load_si128((__m128i *)(a + i + 16)));
+        s2 = _mm_add_epi64(s2, _mm_load_si128((__m128i *)(a + i + 32)));
+        s3 = _mm_add_epi64(s3, _mm_load_si128((__m128i *)(a + i + 48)));
+    }
+    s0 = _mm_add_epi64(_mm_add_epi64(s0, s1), _mm_add_epi64(s2, s3));
+    return (double)_mm_cvtsi128_si64(s0);
+}
+
+double write_sse(char *a, char *b, size_t bytes)
+{
+    __m128i v = _mm_set1_epi64x(1);
+    size_t i;
+    for (i = 0; i < bytes; i += 64)
+    {
+        _mm_store_si128((__m128i *)(a + i), v);
+        _mm_store_si128((__m128i *)(a + i + 16), v);
+        _mm_store_si128((__m128i *)(a + i + 32), v);
+        _mm_store_si128((__m128i *)(a + i + 48), v);
+    }
+    return 0;
+}
+
+double copy_sse(char *a, char *b, size_t bytes)
+{
+    size_t i;
+    for (i = 0; i < bytes; i += 64)
+    {
+        _mm_store_si128((__m128i *)(b + i), _mm_load_si128((__m128i *)(a + i)));
+        _mm_store_si128((__m128i *)(b + i + 16), _mm_load_si128((__m128i *)(a + i + 16)));
+        _mm_store_si128((__m128i *)(b + i + 32), _mm_load_si128((__m128i *)(a + i + 32)));
+        _mm_store_si128((__m128i *)(b + i + 48), _mm_load_si128((__m128i *)(a + i + 48)));
+    }
+    return 0;
+}
+
+__attribute__((target("avx2"))) double read_avx2(char *a, char *b, size_t bytes)
+{
+    __m256i s0 = _mm256_setzero_si256(), s1 = s0;
+    size_t i;
+    for (i = 0; i < bytes; i += 64)
+    {
+        s0 = _mm256_add_epi64(s0, _mm256_load_si256((__m256i *)(a + i)));
+        s1 = _mm256_add_epi64(s1, _mm256_load_si256((__m256i *)(a + i + 32)));
+    }
+    s0 = _mm256_add_epi64(s0, s1);
+    return (double)_mm256_extract_epi64(s0, 0) + (double)_mm256_extract_epi64(s0, 3);
+}
+
+__attribute__((target("avx2"))) double write_avx2(char *a, char *b, size_t bytes)
+{
+    __m256i v = _mm256_set1_epi64x(1);
+    size_t i;
+    for (i = 0; i < bytes; i += 64)
+    {
+        _mm256_store_si256((__m256i *)(a + i), v);
+        _mm256_store_si256((__m256i *)(a + i + 32), v);
+    }
+    return 0;
+}
+
+__attribute__((target("avx2"))) double copy_avx2(char *a, char *b, size_t bytes)
+{
+    size_t i;
+    for (i = 0; i < bytes; i += 64)
+    {
+        _mm256_store_si256((__m256i *)(b + i), _mm256_load_si256((__m256i *)(a + i)));
+        _mm256_store_si256((__m256i *)(b + i + 32), _mm256_load_si256((__m256i *)(a + i + 32)));
+    }
+    return 0;
+}
+#endif
+
+typedef struct
+{
+    const char *name;
+    kernel_t fn;
+    int copies; // copy 每字节既读又写，带宽按读写总量计
+} bw_kernel_t;
+
+bw_kernel_t kernels[] = {
+    {"rd-scalar", read_scalar, 1},
+    {"wr-scalar", write_scalar, 1},
+    {"cp-scalar", copy_scalar, 2},
+#ifdef __x86_64__
+    {"rd-sse", read_sse, 1},
+    {"wr-sse", write_sse, 1},
+    {"cp-sse", copy_sse, 2},
+    {"rd-avx2", read_avx2, 1},
+    {"wr-avx2", write_avx2, 1},
+    {"cp-avx2", copy_avx2, 2},
+#endif
+};
+int nkernels = sizeof(kernels) / sizeof(kernels[0]);
+
+typedef struct
+{
+    buffer_t abuf, bbuf;
+    char *a, *b;
+    size_t size;
+    long reps;
+    kernel_t fn;
+    double sink;
+} bw_arg_t;
+
+pthread_barrier_t bw_start, bw_end;
+
+void *bw_worker(void *arg)
+{
+    bw_arg_t *w = arg;
+    while (1)
+    {
+        pthread_barrier_wait(&bw_start);
+        if (w->fn == NULL)
+            return NULL;
+        long r;
+        for (r = 0; r < w->reps; r++)
+            w->sink += w->fn(w->a, w->b, w->size);
+        pthread_barrier_wait(&bw_end);
+    }
+}
+
+void run_bandwidth(size_t max, long per_point, int nthreads, int ncpus)
+{
+    pthread_t *th = malloc(nthreads * sizeof(pthread_t));
+    bw_arg_t *args = calloc(nthreads, sizeof(bw_arg_t));
+    assert(th != NULL && args != NULL);
+    pthread_barrier_init(&bw_start, NULL, nthreads + 1);
+    pthread_barrier_init(&bw_end, NULL, nthreads + 1);
+    int i, k;
+    for (i = 0; i < nthreads; i++)
+    {
+        args[i].abuf = map_buffer(max);
+        args[i].bbuf = map_buffer(max);
+        args[i].a = args[i].abuf.p;
+        args[i].b = args[i].bbuf.p;
+        Pthread_create_on_cpu(&th[i], i % ncpus, bw_worker, &args[i]);
+    }
+
+    printf("\nthreads: %d  GB/s (total over all threads; copy counts read + write)\n", nthreads);
+    printf("%10s", "size");
+    for (k = 0; k < nkernels; k++)
+        printf(" %9s", kernels[k].name);
+    printf("\n");
+
+#ifdef __x86_64__
+    int have_avx2 = __builtin_cpu_supports("avx2");
+#endif
+    size_t size;
+    for (size = 16384; size <= max; size *= 2)
+    {
+        char buf[32];
+        print_size(size, buf);
+        printf("%10s", buf);
+        for (k = 0; k < nkernels; k++)
+        {
+#ifdef __x86_64__
+            if (strstr(kernels[k].name, "avx2") != NULL && !have_avx2)
+            {
+                printf(" %9s", "n/a");
+                continue;
+            }
+#endif
+            long reps = per_point / size > 0 ? per_point / size : 1;
+            for (i = 0; i < nthreads; i++)
+            {
+                args[i].size = size;
+                args[i].reps = reps;
+                args[i].fn = kernels[k].fn;
+            }
+            pthread_barrier_wait(&bw_start);
+            uint64_t start = cycles_now();
+            pthread_barrier_wait(&bw_end);
+            double ns = cycles_to_ns(cycles_now() - start);
+            double bytes = (double)size * reps * nthreads * kernels[k].copies;
+            printf(" %9.2f", bytes / ns);
+        }
+        printf("\n");
+        fflush(stdout);
+    }
+
+    for (i = 0; i < nthreads; i++)
+        args[i].fn = NULL;
+    pthread_barrier_wait(&bw_start);
+    for (i = 0; i < nthreads; i++)
+    {
+        Pthread_join(th[i], NULL);
+        unmap_buffer(&args[i].abuf);
+        unmap_buffer(&args[i].bbuf);
+    }
+    free(th);
+    free(args);
+}
+
+// ---------------- false sharing ----------------
+
+typedef struct
+{
+    volatile long *counter;
+    long iters;
+} fs_arg_t;
+
+pthread_barrier_t fs_barrier;
+
+void *fs_worker(void *arg)
+{
+    fs_arg_t *w = arg;
+    pthread_barrier_wait(&fs_barrier);
+    long i;
+    for (i = 0; i < w->iters; i++)
+        (*w->counter)++;
+    return NULL;
+}
+
+void run_falseshare(long iters, int nthreads, int ncpus)
+{
+    pthread_t *th = malloc(nthreads * sizeof(pthread_t));
+    fs_arg_t *args = malloc(nthreads * sizeof(fs_arg_t));
+    char *mem = aligned_alloc(4096, 128 * nthreads + 4096);
+    assert(th != NULL && args != NULL && mem != NULL);
+
+    printf("\nthreads: %d  iterations per thread: %ld\n", nthreads, iters);
+    printf("%10s %12s %12s %12s\n", "padding", "lines", "ns/incr", "Mincr/s");
+    int pad, i;
+    for (pad = sizeof(long); pad <= 128; pad *= 2)
+    {
+        memset(mem, 0, 128 * nthreads + 4096);
+        pthread_barrier_init(&fs_barrier, NULL, nthreads + 1);
+        for (i = 0; i < nthreads; i++)
+        {
+            args[i].counter = (volatile long *)(mem + i * pad);
+            args[i].iters = iters;
+            Pthread_create_on_cpu(&th[i], i % ncpus, fs_worker, &args[i]);
+        }
+        uint64_t start = cycles_now();
+        pthread_barrier_wait(&fs_barrier);
+        for (i = 0; i < nthreads; i++)
+            Pthread_join(th[i], NULL);
+        double ns = cycles_to_ns(cycles_now() - start);
+        pthread_barrier_destroy(&fs_barrier);
+        for (i = 0; i < nthreads; i++)
+            assert(*args[i].counter == iters);
+        int lines = (nthreads * pad + LINE - 1) / LINE;
+        printf("%10d %12d %12.2f %12.1f\n", pad, lines, ns / iters, nthreads * iters / ns * 1e3);
+    }
+    free(th);
+    free(args);
+    free(mem);
+}
+
+void usage()
+{
+    fprintf(stderr, "usage: memhier -t latency|bandwidth|falseshare [-s max-size] [-a work-per-point] "
+                    "[-T threads,...] [-P]\n");
+    exit(1);
+}
+
+int main(int argc, char *argv[])
+{
+    char *test = NULL;
+    size_t max = 0;
+    long work = 0;
+    char *threads = "1";
+    int opt;
+    while ((opt = getopt(argc, argv, "t:s:a:T:P")) != -1)
+    {
+        switch (opt)
+        {
+        case 't': test = optarg; break;
+        case 's': max = parse_size(optarg); break;
+        case 'a': work = (long)parse_size(optarg); break;
+        case 'T': threads = optarg; break;
+        case 'P': use_thp = 0; break;
+        default:  usage();
+        }
+    }
+    if (test == NULL)
+        usage();
+
+    int ncpus = sysconf(_SC_NPROCESSORS_ONLN);
+    size_t half_ram = (size_t)sysconf(_SC_PHYS_PAGES) * sysconf(_SC_PAGESIZE) / 2;
+    cycles_calibrate(100);
+    printf("cpus: %d  counter: %.3f cycles/ns  pages: %s\n", ncpus, cycles_per_ns, use_thp ? "thp" : "4k");
+    print_caches();
+
+    if (strcmp(test, "latency") == 0)
+    {
+        if (max == 0)
+            max = 4UL << 30;
+        if (max > half_ram)
+        {
+            max = half_ram;
+            printf("working set capped at half of physical memory\n");
+        }
+        Pin_to_cpu(0);
+        run_latency(max, work > 0 ? work : 20000000);
+        return 0;
+    }
+
+    // -T 1,2,4：每个线程数跑一遍
+    char *list = strdup(threads), *save = NULL, *tok;
+    for (tok = strtok_r(list, ",", &save); tok != NULL; tok = strtok_r(NULL, ",", &save))
+    {
+        int n = atoi(tok);
+        assert(n > 0);
+        if (strcmp(test, "bandwidth") == 0)
+        {
+            // 每个线程数单独计算上限，不影响后面的线程数
+            size_t size = max > 0 ? max : 256UL << 20;
+            if (2 * size * n > half_ram)
+                size = half_ram / (2 * n);
+            run_bandwidth(size, work > 0 ? work : 1L << 30, n, ncpus);
+        }
+        else if (strcmp(test, "falseshare") == 0)
+            run_falseshare(work > 0 ? work : 50000000, n, ncpus);
+        else
+            usage();
+    }
+    free(list);
+    return 0;
+}
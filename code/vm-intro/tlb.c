@@ -0,0 +1,194 @@
+// 测量 TLB 的实际大小与未命中代价（va.c 的延伸）
+// 在 N 个页上做指针追逐，重复多次，输出每次访问的平均时间随 N 的变化：
+// N 超过某一级 TLB 的容量时，每次访问的时间会出现一个台阶。
+// 每个页里放一个指针，N 个页由 rng.h 中的 rng_cycle 连成一个随机的单环，
+// 每次加载的地址来自上一次加载，页表遍历不能被乱序执行重叠，测到的是完整的未命中代价。
+//
+// 三种内存：
+//   4k      - 普通 4KB 页（同时用 MADV_NOHUGEPAGE 关掉透明大页）
+//   thp     - 2MB 对齐的区域 + madvise(MADV_HUGEPAGE)，由透明大页机制映射
+//   hugetlb - mmap(MAP_HUGETLB)，需要预留大页：echo N > /proc/sys/vm/nr_hugepages
+// 大页模式下访问步长仍是 4KB，同样的 N 需要的 TLB 表项少 512 倍。
+//
+// 第 i 个页的指针放在页内偏移 (i * 64) % 4096 处，这样各次访问落在不同的缓存组里，
+// 台阶来自 TLB 而不是 L1 缓存的组冲突。
+// 进程绑定在一个 CPU 上，计时用 cycles.h 中校准过的周期计数器。
+//
+// To compile: make
+// To run:     ./tlb -m 4k -p 16384 && ./tlb -m thp -p 16384
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#include "common_threads.h"
+#include "cycles.h"
+#include "rng.h"
+
+#define PAGE      4096
+#define HUGE_PAGE (2 * 1024 * 1024)
+
+typedef enum
+{
+    MEM_4K,
+    MEM_THP,
+    MEM_HUGETLB
+} mem_mode_t;
+
+const char *mode_names[] = {"4k", "thp", "hugetlb"};
+
+char *map_region(mem_mode_t mode, long bytes)
+{
+    bytes = (bytes + HUGE_PAGE - 1) / HUGE_PAGE * HUGE_PAGE;
+    char *p;
+    if (mode == MEM_HUGETLB)
+    {
+        p = mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (p == MAP_FAILED)
+        {
+            fprintf(stderr, "tlb: MAP_HUGETLB failed; reserve at least %ld huge pages in /proc/sys/vm/nr_hugepages\n",
+                    bytes / HUGE_PAGE);
+            exit(1);
+        }
+        return p;
+    }
+    // 多映射 2MB 再手动对齐，透明大页只能用于 2MB 对齐的区域
+    char *raw = mmap(NULL, bytes + HUGE_PAGE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    assert(raw != MAP_FAILED);
+    p = (char *)(((unsigned long)raw + HUGE_PAGE - 1) & ~(unsigned long)(HUGE_PAGE - 1));
+    assert(madvise(p, bytes, mode == MEM_THP ? MADV_HUGEPAGE : MADV_NOHUGEPAGE) == 0);
+    return p;
+}
+
+// 透明大页的全局设置，例如 "always [madvise] never"
+void print_thp_setting()
+{
+    char buf[128];
+    FILE *fp = fopen("/sys/kernel/mm/transparent_hugepage/enabled", "r");
+    if (fp == NULL)
+        return;
+    if (fgets(buf, sizeof(buf), fp) != NULL)
+        printf("transparent_hugepage: %s", buf);
+    fclose(fp);
+}
+
+// 本进程实际得到的透明大页总量，用来确认 thp 模式确实用上了大页
+void print_anon_huge()
+{
+    char line[256];
+    FILE *fp = fopen("/proc/self/smaps_rollup", "r");
+    if (fp == NULL)
+        return;
+    while (fgets(line, sizeof(line), fp) != NULL)
+        if (strncmp(line, "AnonHugePages:", 14) == 0)
+            printf("%s", line);
+    fclose(fp);
+}
+
+// 第 i 个页中存放指针的位置
+static inline void **slot(char *mem, long i)
+{
+    return (void **)(mem + i * PAGE + (i * 64) % PAGE);
+}
+
+uint32_t *next; // 每个页的后继
+rng_t rng;
+
+// 把前 npages 个页连成随机单环，返回环上的一个节点
+void **build_chain(char *mem, long npages)
+{
+    long i;
+    rng_cycle(&rng, next, npages);
+    for (i = 0; i < npages; i++)
+        *slot(mem, i) = slot(mem, next[i]);
+    return slot(mem, 0);
+}
+
+// 沿环走 n 步（n 是 8 的倍数），返回每次访问的纳秒数
+double measure(void ***pp, long n)
+{
+    void **p = *pp;
+    long i;
+    uint64_t start = cycles_now();
+    for (i = 0; i < n; i += 8)
+    {
+        p = *p; p = *p; p = *p; p = *p;
+        p = *p; p = *p; p = *p; p = *p;
+    }
+    uint64_t end = cycles_now();
+    *pp = p;
+    return cycles_to_ns(end - start) / n;
+}
+
+double last_ns = 0;
+
+void run_point(char *mem, long npages, long per_point)
+{
+    void **p = build_chain(mem, npages);
+    long n = per_point / 8 * 8 > 8 ? per_point / 8 * 8 : 8;
+    measure(&p, (npages + 7) / 8 * 8); // 预热：至少走一整圈
+    double ns = measure(&p, n);
+    printf("%10ld %12ld %12.3f%s\n", npages, npages * PAGE / 1024, ns,
+           last_ns > 0 && ns > last_ns * 1.3 ? "   <- step" : "");
+    last_ns = ns;
+}
+
+void usage()
+{
+    fprintf(stderr, "usage: tlb [-m 4k|thp|hugetlb] [-p max-pages] [-a accesses-per-point] [-c cpu]\n");
+    exit(1);
+}
+
+int main(int argc, char *argv[])
+{
+    mem_mode_t mode = MEM_4K;
+    long max_pages = 16384;
+    long per_point = 20000000;
+    int cpu = 0;
+    int opt;
+    while ((opt = getopt(argc, argv, "m:p:a:c:")) != -1)
+    {
+        switch (opt)
+        {
+        case 'p': max_pages = atol(optarg); break;
+        case 'a': per_point = atol(optarg); break;
+        case 'c': cpu = atoi(optarg); break;
+        case 'm':
+            for (mode = MEM_4K; mode <= MEM_HUGETLB; mode++)
+                if (strcmp(optarg, mode_names[mode]) == 0)
+                    break;
+            if (mode > MEM_HUGETLB)
+                usage();
+            break;
+        default:
+            usage();
+        }
+    }
+    assert(max_pages > 0 && per_point > 0);
+
+    Pin_to_cpu(cpu);
+    cycles_calibrate(100);
+    char *mem = map_region(mode, max_pages * PAGE);
+    memset(mem, 0, max_pages * PAGE); // 预先触发缺页，测量中不再有缺页
+    next = malloc(max_pages * sizeof(uint32_t));
+    assert(next != NULL);
+    rng_seed(&rng, 1);
+
+    printf("mode: %s  cpu: %d  counter: %.3f cycles/ns\n", mode_names[mode], cpu, cycles_per_ns);
+    print_thp_setting();
+    print_anon_huge();
+    printf("%10s %12s %12s\n", "pages", "KB-spanned", "ns/access");
+
+    // 每个 2 的幂之间再取一个 1.5 倍的点，台阶的位置更准确
+    long p;
+    for (p = 1; p <= max_pages; p *= 2)
+    {
+        run_point(mem, p, per_point);
+        if (p >= 2 && p + p / 2 <= max_pages)
+            run_point(mem, p + p / 2, per_point);
+    }
+    return 0;
+}
@@ -0,0 +1,530 @@
+// 地址转换模拟器：页表 + 组相联 TLB
+//
+// 页表结构（-t）：
+//   linear   - 线性页表：每个地址空间一张从 0 到最高虚拟页号的数组，查表 1 次访存
+//   2level   - 两级页表：虚拟页号拆成 18 + 18 位，查表 2 次访存
+//   4level   - x86-64 四级页表：9 + 9 + 9 + 9 位，每个节点 4KB，查表 4 次访存（2MB 大页 3 次）
+//   inverted - 反向页表：每个物理页框一项，用 (asid, vpn) 散列到锚表再沿链查找
+//   hashed   - 散列页表：桶数组 + 链表，每个已映射的页一个节点
+// 三种基数树结构共用一棵按需分配的四级树保存映射，只是按各自的结构统计访存次数与内存开销；
+// 反向页表与散列页表是真实实现的，链长即访存次数。
+//
+// TLB：4KB 页与 2MB 页各一个组相联 TLB（组内 LRU），表项带 ASID 标签；
+// 用 -n 关闭 ASID 时，每次切换地址空间都要清空 TLB。
+// 大页（-H pct）：每个 2MB 区域按其编号的散列值决定是否用大页映射，大约 pct% 的区域是大页。
+//
+// trace 是二进制文件，每条记录一个 64 位整数：低 48 位是虚拟地址，高 16 位是 ASID（只用低 15 位）。
+// 文件用 mmap 读入，不受内存大小限制；-G 生成合成 trace。
+//
+// To compile: make
+// To run:     ./translate -G 10000000 -o trace.bin && ./translate -f trace.bin -t 4level -H 50
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "common.h"
+#include "rng.h"
+
+#define PAGE_SHIFT 12
+#define HUGE_SHIFT 21
+#define VA_MASK    ((1ULL << 48) - 1)
+#define MAX_ASIDS  (1 << 16)
+
+typedef enum
+{
+    PT_LINEAR,
+    PT_2LEVEL,
+    PT_4LEVEL,
+    PT_INVERTED,
+    PT_HASHED
+} pt_kind_t;
+
+const char *pt_names[] = {"linear", "2level", "4level", "inverted", "hashed"};
+
+// ---------------- 参数 ----------------
+
+pt_kind_t kind = PT_4LEVEL;
+int tlb_entries = 64;       // 4KB TLB 表项数
+int tlb_ways = 4;
+int huge_entries = 32;      // 2MB TLB 表项数
+int huge_pct = 0;           // 使用大页的 2MB 区域比例
+int use_asid = 1;
+long phys_mb = 16384;       // 物理内存大小（反向页表按它分配）
+long hash_buckets = 1 << 20;
+
+// ---------------- 统计 ----------------
+
+long accesses = 0;
+long tlb_hits = 0, huge_hits = 0;
+long walks = 0, walk_refs = 0;
+long faults = 0;            // 首次访问（建立映射）
+long switches = 0, flushes = 0;
+uint64_t next_pfn = 0;      // 物理页框按需顺序分配
+
+// ---------------- TLB ----------------
+
+typedef struct
+{
+    uint64_t tag;  // make_tag(asid, vpn)，0 表示无效
+    uint64_t pfn;
+    long used;     // LRU 时间戳
+} tlb_entry_t;
+
+typedef struct
+{
+    tlb_entry_t *e;
+    int sets;
+    int ways;
+    long clock;
+} tlb_t;
+
+tlb_t tlb4k, tlb2m;
+
+void tlb_init(tlb_t *t, int entries, int ways)
+{
+    assert(entries > 0 && ways > 0 && entries % ways == 0);
+    t->sets = entries / ways;
+    assert((t->sets & (t->sets - 1)) == 0); // 组数为 2 的幂
+    t->ways = ways;
+    t->e = calloc(entries, sizeof(tlb_entry_t));
+    assert(t->e != NULL);
+    t->clock = 0;
+}
+
+void tlb_flush(tlb_t *t)
+{
+    memset(t->e, 0, sizeof(tlb_entry_t) * t->sets * t->ways);
+}
+
+// tag 的第 63 位恒为 1（ASID 只用 15 位），用来区分有效表项与清零的表项
+static inline uint64_t make_tag(int asid, uint64_t vpn)
+{
+    return (1ULL << 63) | ((uint64_t)(asid & 0x7fff) << 48) | vpn;
+}
+
+static inline int tlb_lookup(tlb_t *t, uint64_t tag, uint64_t vpn, uint64_t *pfn)
+{
+    tlb_entry_t *set = &t->e[(vpn & (t->sets - 1)) * t->ways];
+    int w;
+    for (w = 0; w < t->ways; w++)
+        if (set[w].tag == tag)
+        {
+            set[w].used = ++t->clock;
+            *pfn = set[w].pfn;
+            return 1;
+        }
+    return 0;
+}
+
+static inline void tlb_insert(tlb_t *t, uint64_t tag, uint64_t vpn, uint64_t pfn)
+{
+    tlb_entry_t *set = &t->e[(vpn & (t->sets - 1)) * t->ways];
+    int w, victim = 0;
+    for (w = 1; w < t->ways; w++)
+        if (set[w].used < set[victim].used)
+            victim = w;
+    set[victim].tag = tag;
+    set[victim].pfn = pfn;
+    set[victim].used = ++t->clock;
+}
+
+// ---------------- 四级基数树（linear / 2level / 4level 共用） ----------------
+
+typedef struct node_t
+{
+    void *slot[512];
+} node_t;
+
+node_t *roots[MAX_ASIDS];
+long nodes[5];                   // 第 d 层（根为 1）的节点数
+uint64_t max_vpn[MAX_ASIDS];     // 线性页表的长度
+int asids_seen = 0;
+
+node_t *node_new(int depth)
+{
+    node_t *n = calloc(1, sizeof(node_t));
+    assert(n != NULL);
+    nodes[depth]++;
+    return n;
+}
+
+uint64_t alloc_frames(int huge)
+{
+    uint64_t pfn;
+    if (huge)
+    {
+        next_pfn = (next_pfn + 511) & ~511ULL; // 大页要求 2MB 对齐
+        pfn = next_pfn;
+        next_pfn += 512;
+    }
+    else
+        pfn = next_pfn++;
+    return pfn;
+}
+
+// 叶子槽中保存 pfn + 1（0 表示未映射）
+uint64_t radix_walk(int asid, uint64_t vpn, int huge)
+{
+    if (roots[asid] == NULL)
+    {
+        roots[asid] = node_new(1);
+        asids_seen++;
+    }
+    if (vpn > max_vpn[asid])
+        max_vpn[asid] = vpn;
+    node_t *n = roots[asid];
+    int depth;
+    int leaf = huge ? 3 : 4;
+    for (depth = 1; depth < leaf; depth++)
+    {
+        void **s = &n->slot[(vpn >> (9 * (4 - depth))) & 511];
+        if (*s == NULL)
+            *s = node_new(depth + 1);
+        n = *s;
+    }
+    void **s = &n->slot[(vpn >> (9 * (4 - leaf))) & 511];
+    if (*s == NULL)
+    {
+        faults++;
+        *s = (void *)(uintptr_t)(alloc_frames(huge) + 1);
+    }
+    uint64_t pfn = (uint64_t)(uintptr_t)*s - 1;
+    if (kind == PT_LINEAR)
+        walk_refs += 1;
+    else if (kind == PT_2LEVEL)
+        walk_refs += 2;
+    else
+        walk_refs += leaf;
+    return pfn;
+}
+
+// ---------------- 反向页表 ----------------
+
+typedef struct
+{
+    uint64_t key;  // make_tag(asid, vpn)，大页另置第 62 位
+    uint32_t next; // 同一散列链上的下一个页框 + 1，0 表示链尾
+    uint32_t pad;
+} ipt_entry_t;
+
+ipt_entry_t *ipt;
+uint32_t *anchor;   // 散列锚表：每个桶指向链头页框 + 1
+uint64_t nframes, anchor_mask;
+
+static inline uint64_t hash_key(uint64_t key)
+{
+    key ^= key >> 33;
+    key *= 0xff51afd7ed558ccdULL;
+    key ^= key >> 33;
+    return key;
+}
+
+void ipt_init()
+{
+    nframes = (uint64_t)phys_mb << (20 - PAGE_SHIFT);
+    uint64_t buckets = 1;
+    while (buckets < nframes)
+        buckets <<= 1;
+    anchor_mask = buckets - 1;
+    ipt = calloc(nframes, sizeof(ipt_entry_t));
+    anchor = calloc(buckets, sizeof(uint32_t));
+    assert(ipt != NULL && anchor != NULL);
+}
+
+uint64_t ipt_walk(uint64_t key, int huge)
+{
+    uint32_t *b = &anchor[hash_key(key) & anchor_mask];
+    walk_refs++; // 读锚表
+    uint32_t f;
+    for (f = *b; f != 0; f = ipt[f - 1].next)
+    {
+        walk_refs++;
+        if (ipt[f - 1].key == key)
+            return f - 1;
+    }
+    faults++;
+    uint64_t pfn = alloc_frames(huge);
+    if (next_pfn > nframes)
+    {
+        fprintf(stderr, "translate: physical memory exhausted, raise -M\n");
+        exit(1);
+    }
+    ipt[pfn].key = key;
+    ipt[pfn].next = *b;
+    *b = pfn + 1;
+    return pfn;
+}
+
+// ---------------- 散列页表 ----------------
+
+typedef struct hnode_t
+{
+    uint64_t key;
+    uint64_t pfn;
+    struct hnode_t *next;
+} hnode_t;
+
+hnode_t **buckets;
+long hnodes = 0;
+
+hnode_t *hnode_pool = NULL;
+int hnode_left = 0;
+
+uint64_t hashed_walk(uint64_t key, int huge)
+{
+    hnode_t **b = &buckets[hash_key(key) & (hash_buckets - 1)];
+    walk_refs++; // 读桶
+    hnode_t *h;
+    for (h = *b; h != NULL; h = h->next)
+    {
+        walk_refs++;
+        if (h->key == key)
+            return h->pfn;
+    }
+    faults++;
+    if (hnode_left == 0)
+    {
+        hnode_pool = malloc(sizeof(hnode_t) * 4096);
+        assert(hnode_pool != NULL);
+        hnode_left = 4096;
+    }
+    h = &hnode_pool[--hnode_left];
+    h->key = key;
+    h->pfn = alloc_frames(huge);
+    h->next = *b;
+    *b = h;
+    hnodes++;
+    return h->pfn;
+}
+
+// ---------------- 转换 ----------------
+
+// 该 2MB 区域是否用大页映射：按区域编号散列，结果对同一区域固定
+static inline int is_huge(int asid, uint64_t va)
+{
+    if (huge_pct == 0)
+        return 0;
+    return hash_key(((uint64_t)asid << 48) | (va >> HUGE_SHIFT)) % 100 < (uint64_t)huge_pct;
+}
+
+static inline void translate(int asid, uint64_t va)
+{
+    int huge = is_huge(asid, va);
+    uint64_t vpn = va >> (huge ? HUGE_SHIFT : PAGE_SHIFT);
+    int tag_asid = use_asid ? asid : 0;
+    uint64_t tag = make_tag(tag_asid, vpn);
+    uint64_t pfn;
+    tlb_t *t = huge ? &tlb2m : &tlb4k;
+    accesses++;
+    if (tlb_lookup(t, tag, vpn, &pfn))
+    {
+        if (huge)
+            huge_hits++;
+        else
+            tlb_hits++;
+        return;
+    }
+    walks++;
+    uint64_t key = make_tag(asid, vpn) | ((uint64_t)huge << 62);
+    if (kind == PT_INVERTED)
+        pfn = ipt_walk(key, huge);
+    else if (kind == PT_HASHED)
+        pfn = hashed_walk(key, huge);
+    else
+        pfn = radix_walk(asid, huge ? vpn << 9 : vpn, huge);
+    tlb_insert(t, tag, vpn, pfn);
+}
+
+// 页表本身占用的内存（字节）
+double table_bytes()
+{
+    int a;
+    double bytes = 0;
+    switch (kind)
+    {
+    case PT_LINEAR:
+        for (a = 0; a < MAX_ASIDS; a++)
+            if (roots[a])
+                bytes += (max_vpn[a] + 1) * 8.0;
+        return bytes;
+    case PT_2LEVEL:
+        // 顶层 2^18 项；每个用到的 2^18 页区间（即四级树的第 3 层节点所覆盖的范围）一张二级表
+        return asids_seen * (1 << 18) * 8.0 + nodes[3] * (1 << 18) * 8.0;
+    case PT_4LEVEL:
+        return (nodes[1] + nodes[2] + nodes[3] + nodes[4]) * 4096.0;
+    case PT_INVERTED:
+        return nframes * (double)sizeof(ipt_entry_t) + (anchor_mask + 1) * 4.0;
+    case PT_HASHED:
+        return hash_buckets * 8.0 + hnodes * (double)sizeof(hnode_t);
+    }
+    return 0;
+}
+
+// ---------------- trace 生成 ----------------
+
+// 每个地址空间一个工作集；访问以 local% 的概率顺序前进一个缓存行，否则跳到工作集内随机位置
+void generate(long count, const char *out, int procs, long ws_mb, int local, long switch_every, uint64_t seed)
+{
+    FILE *fp = fopen(out, "w");
+    assert(fp != NULL);
+    rng_t rng;
+    rng_seed(&rng, seed);
+    uint64_t ws = (uint64_t)ws_mb << 20;
+    uint64_t *cur = calloc(procs, sizeof(uint64_t));
+    uint64_t buf[4096];
+    assert(cur != NULL);
+    int p = 0, n = 0;
+    long i;
+    for (i = 0; i < count; i++)
+    {
+        if (i > 0 && i % switch_every == 0)
+            p = (p + 1) % procs;
+        if ((int)rng_bounded(&rng, 100) < local)
+            cur[p] = (cur[p] + 64) % ws;
+        else
+            cur[p] = rng_bounded(&rng, ws) & ~63ULL;
+        uint64_t base = (uint64_t)(p + 1) << 36; // 每个进程的工作集放在不同的 64GB 区域
+        buf[n++] = ((uint64_t)(p + 1) << 48) | ((base + cur[p]) & VA_MASK);
+        if (n == 4096)
+        {
+            assert(fwrite(buf, sizeof(uint64_t), n, fp) == (size_t)n);
+            n = 0;
+        }
+    }
+    if (n > 0)
+        assert(fwrite(buf, sizeof(uint64_t), n, fp) == (size_t)n);
+    fclose(fp);
+    free(cur);
+}
+
+void usage()
+{
+    fprintf(stderr, "usage: translate -f <trace> [-t linear|2level|4level|inverted|hashed]\n"
+                    "                 [-e tlb-entries] [-a ways] [-E huge-tlb-entries] [-H huge-pct] [-n]\n"
+                    "                 [-M phys-MB] [-B hash-buckets]\n"
+                    "       translate -G <accesses> -o <trace> [-P procs] [-w ws-MB] [-l local-pct]\n"
+                    "                 [-x switch-every] [-s seed]\n");
+    exit(1);
+}
+
+int main(int argc, char *argv[])
+{
+    char *tracefile = NULL, *outfile = NULL;
+    long gen = 0, ws_mb = 256, switch_every = 100000;
+    int procs = 4, local = 90;
+    uint64_t seed = 1;
+    int opt;
+    while ((opt = getopt(argc, argv, "f:t:e:a:E:H:nM:B:G:o:P:w:l:x:s:")) != -1)
+    {
+        switch (opt)
+        {
+        case 'f': tracefile = optarg; break;
+        case 'e': tlb_entries = atoi(optarg); break;
+        case 'a': tlb_ways = atoi(optarg); break;
+        case 'E': huge_entries = atoi(optarg); break;
+        case 'H': huge_pct = atoi(optarg); break;
+        case 'n': use_asid = 0; break;
+        case 'M': phys_mb = atol(optarg); break;
+        case 'B': hash_buckets = atol(optarg); break;
+        case 'G': gen = atol(optarg); break;
+        case 'o': outfile = optarg; break;
+        case 'P': procs = atoi(optarg); break;
+        case 'w': ws_mb = atol(optarg); break;
+        case 'l': local = atoi(optarg); break;
+        case 'x': switch_every = atol(optarg); break;
+        case 's': seed = atol(optarg); break;
+        case 't':
+            for (kind = PT_LINEAR; kind <= PT_HASHED; kind++)
+                if (strcmp(optarg, pt_names[kind]) == 0)
+                    break;
+            if (kind > PT_HASHED)
+                usage();
+            break;
+        default:
+            usage();
+        }
+    }
+
+    if (gen > 0)
+    {
+        if (outfile == NULL)
+            usage();
+        assert(procs > 0 && procs < MAX_ASIDS / 2 && ws_mb > 0 && switch_every > 0);
+        generate(gen, outfile, procs, ws_mb, local, switch_every, seed);
+        return 0;
+    }
+    if (tracefile == NULL)
+        usage();
+    assert(huge_pct >= 0 && huge_pct <= 100);
+    assert(hash_buckets > 0 && (hash_buckets & (hash_buckets - 1)) == 0);
+
+    int fd = open(tracefile, O_RDONLY);
+    if (fd < 0)
+    {
+        perror(tracefile);
+        exit(1);
+    }
+    struct stat st;
+    assert(fstat(fd, &st) == 0);
+    long n = st.st_size / sizeof(uint64_t);
+    assert(n > 0);
+    uint64_t *trace = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    assert(trace != MAP_FAILED);
+    madvise(trace, st.st_size, MADV_SEQUENTIAL);
+
+    tlb_init(&tlb4k, tlb_entries, tlb_ways);
+    tlb_init(&tlb2m, huge_entries, huge_entries < tlb_ways ? huge_entries : tlb_ways);
+    if (kind == PT_INVERTED)
+        ipt_init();
+    if (kind == PT_HASHED)
+    {
+        buckets = calloc(hash_buckets, sizeof(hnode_t *));
+        assert(buckets != NULL);
+    }
+
+    int last_asid = -1;
+    long i;
+    double start = GetTime();
+    for (i = 0; i < n; i++)
+    {
+        int asid = (int)(trace[i] >> 48) & (MAX_ASIDS / 2 - 1);
+        if (asid != last_asid)
+        {
+            if (last_asid >= 0)
+            {
+                switches++;
+                if (!use_asid)
+                {
+                    tlb_flush(&tlb4k);
+                    tlb_flush(&tlb2m);
+                    flushes++;
+                }
+            }
+            last_asid = asid;
+        }
+        translate(asid, trace[i] & VA_MASK);
+    }
+    double elapsed = GetTime() - start;
+
+    long hits = tlb_hits + huge_hits;
+    printf("page table:   %s  tlb: %d x %d-way (4KB) + %d (2MB)  huge pages: %d%%  asid: %s\n",
+           pt_names[kind], tlb_entries, tlb_ways, huge_entries, huge_pct, use_asid ? "on" : "off");
+    printf("accesses:     %ld  (%ld address-space switches, %ld TLB flushes)\n", accesses, switches, flushes);
+    printf("tlb hit rate: %.4f%%  (4KB hits %ld, 2MB hits %ld)\n", 100.0 * hits / accesses, tlb_hits, huge_hits);
+    printf("page walks:   %ld  (%.2f memory refs per walk, %.4f per access)\n",
+           walks, walks ? (double)walk_refs / walks : 0, (double)walk_refs / accesses);
+    printf("pages mapped: %ld  (%.1f MB of physical memory touched)\n",
+           faults, next_pfn * 4096.0 / (1 << 20));
+    printf("table memory: %.3f MB\n", table_bytes() / (1 << 20));
+    printf("sim speed:    %.1f M accesses/sec\n", accesses / elapsed / 1e6);
+
+    munmap(trace, st.st_size);
+    close(fd);
+    return 0;
+}